@@ -2,6 +2,20 @@
 #pragma GCC optimize(3)
 
 #include <bits/stdc++.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <csignal>
+#endif
+// õľȷģļύʱûиͷļ˻صԤֵѡ
+#if __has_include("validator.h")
+#include "validator.h"
+#define HAS_EXACT_EVALUATOR
+#endif
 #define MAX_RUN_TIME (28)
 
 
@@ -23,6 +37,64 @@ using arr4 = std::array<int, 4>;
     #define LOG(...) do {} while(0)
 #endif
 
+// ===================================================================
+// START: Fast Output
+// ===================================================================
+
+/*Ԥ仺дתʱһдfd׷ӵsinkַ*/
+class FastWriter {
+public:
+    explicit FastWriter(int fd = 1, size_t capacity = 1 << 22): fd(fd), sink(nullptr), buffer(capacity), pos(0) {}
+    explicit FastWriter(std::string* sink, size_t capacity = 1 << 20): fd(-1), sink(sink), buffer(capacity), pos(0) {}
+    ~FastWriter() { flush(); }
+
+    void put_int(long long v) {
+        if (pos + 24 > buffer.size()) flush();
+        char* out = buffer.data() + pos;
+        unsigned long long u = v;
+        if (v < 0) { *out ++ = '-'; u = 0ULL - u; }
+        char tmp[24];
+        int n = 0;
+        do { tmp[n ++] = '0' + u % 10; u /= 10; } while (u);
+        while (n) *out ++ = tmp[-- n];
+        pos = out - buffer.data();
+    }
+
+    void put_char(char c) {
+        if (pos == buffer.size()) flush();
+        buffer[pos ++] = c;
+    }
+
+    void flush() {
+        if (sink != nullptr) {
+            sink->append(buffer.data(), pos);
+            pos = 0;
+            return;
+        }
+        size_t done = 0;
+        while (done < pos) {
+#ifndef _WIN32
+            ssize_t n = ::write(fd, buffer.data() + done, pos - done);
+            if (n < 0) { if (errno == EINTR) continue; break; }
+#else
+            size_t n = fwrite(buffer.data() + done, 1, pos - done, fd == 2 ? stderr : stdout);
+            if (n == 0) break;
+#endif
+            done += n;
+        }
+#ifdef _WIN32
+        fflush(fd == 2 ? stderr : stdout);
+#endif
+        pos = 0;
+    }
+
+private:
+    int fd;
+    std::string* sink;
+    std::vector<char> buffer;
+    size_t pos;
+};
+
 // ===================================================================
 // START: Data Structures & Classes
 // ===================================================================
@@ -32,13 +104,33 @@ struct NPU {
     int npu_id;
     int k;
     int memory;
+    const int* time_table = nullptr; // ԤĴʱHandleTimeTable
+    int time_table_size = 0;
 
     int calculate_time (int batchSize) const {
         assert(batchSize >= 0);
+        if (batchSize < time_table_size) return time_table[batchSize];
         return ceil(sqrtl(batchSize) / k);
     }
 };
 
+/*(k, memory) ceil(sqrt(batch)/k) ıʵפģʽ¿*/
+class HandleTimeTable {
+public:
+    static void attach(NPU& npu) {
+        static std::mutex mutex;
+        static std::map<std::pair<int, int>, std::vector<int> > tables;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& table = tables[{npu.k, npu.memory}];
+        if (table.empty()) {
+            table.resize(std::max(npu.memory, 0) + 1);
+            for (int b = 0; b < (int)table.size(); b ++) table[b] = ceil(sqrtl(b) / npu.k);
+        }
+        npu.time_table = table.data();
+        npu.time_table_size = table.size();
+    }
+};
+
 struct User {
     int id; // ûid
     int s, e, cnt;
@@ -62,46 +154,500 @@ struct Schedule {
     int batch_size;
 };
 
+/*ֹʱȡǣģѭ飻ǱȡʱӱͬΪȡ*/
+class CancellationToken {
+public:
+    explicit CancellationToken(std::chrono::steady_clock::time_point deadline, 
+        const CancellationToken* parent = nullptr): deadline(deadline), parent(parent) {}
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool is_cancelled() const {
+        if (cancelled.load(std::memory_order_relaxed)) return true;
+        if (parent != nullptr && parent->is_cancelled()) return true;
+        return std::chrono::steady_clock::now() >= deadline;
+    }
+
+private:
+    std::chrono::steady_clock::time_point deadline;
+    const CancellationToken* parent;
+    std::atomic<bool> cancelled{false};
+};
+
+/*ȫʱԤ㣬ӳڿʼʱ
+ʱ׶ռȿͨ --time-limit= --phase-shares=a,b,c,d ָ
+ζȡ SOLVER_TIME_LIMIT / SOLVER_PHASE_SHARESûʱʹĬֵ
+*/
+class TimeBudget {
+public:
+    enum Phase { ITERATE = 0, HANDLE, COMPACT, OUTPUT, PHASE_COUNT };
+
+    TimeBudget(std::chrono::steady_clock::time_point start, double total_seconds, 
+        const std::array<double, PHASE_COUNT>& shares): start(start), total_seconds(total_seconds), shares(shares) {}
+
+    static TimeBudget from_args(int argc, char* argv[], std::chrono::steady_clock::time_point start) {
+        double total_seconds = MAX_RUN_TIME;
+        std::array<double, PHASE_COUNT> shares = {0.88, 0.07, 0.03, 0.02};
+
+        const char* env_total = std::getenv("SOLVER_TIME_LIMIT");
+        const char* env_shares = std::getenv("SOLVER_PHASE_SHARES");
+        if (env_total != nullptr) parse_total(env_total, total_seconds);
+        if (env_shares != nullptr) parse_shares(env_shares, shares);
+        for (int i = 1; i < argc; i ++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--time-limit=", 0) == 0) parse_total(arg.substr(13), total_seconds);
+            else if (arg.rfind("--phase-shares=", 0) == 0) parse_shares(arg.substr(15), shares);
+        }
+        LOG("time budget: %.2fs, shares: %.2f %.2f %.2f %.2f", total_seconds, 
+            shares[ITERATE], shares[HANDLE], shares[COMPACT], shares[OUTPUT]);
+        return TimeBudget(start, total_seconds, shares);
+    }
+
+    /*׶pĽֹʱ䣬ǰ׶ûʱԶ˳ӸĽ׶*/
+    std::chrono::steady_clock::time_point deadline(Phase p) const {
+        double sum = 0, acc = 0;
+        for (int i = 0; i < PHASE_COUNT; i ++) {
+            sum += shares[i];
+            if (i <= p) acc += shares[i];
+        }
+        std::chrono::duration<double> offset(total_seconds * acc / sum);
+        return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+    }
+
+    double elapsed() const {
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        return d.count();
+    }
+
+    /*ͬáµ㿪ʼʱפģʽÿһԤ*/
+    TimeBudget restarted(std::chrono::steady_clock::time_point new_start) const {
+        return TimeBudget(new_start, total_seconds, shares);
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    double total_seconds;
+    std::array<double, PHASE_COUNT> shares;
+
+    static void parse_total(const std::string& text, double& total_seconds) {
+        char* end = nullptr;
+        double v = std::strtod(text.c_str(), &end);
+        if (end != text.c_str() && v > 0) total_seconds = v;
+    }
+
+    static void parse_shares(const std::string& text, std::array<double, PHASE_COUNT>& shares) {
+        std::array<double, PHASE_COUNT> parsed{};
+        std::stringstream ss(text);
+        std::string item;
+        int n = 0;
+        while (std::getline(ss, item, ',')) {
+            if (n >= PHASE_COUNT) return;
+            char* end = nullptr;
+            double v = std::strtod(item.c_str(), &end);
+            if (end == item.c_str() || v < 0) return;
+            parsed[n ++] = v;
+        }
+        if (n != PHASE_COUNT || std::accumulate(parsed.begin(), parsed.end(), 0.0) <= 0) return;
+        shares = parsed;
+    }
+};
+
+/*ֻӳļӳͬһļʱҳ֧mmapʱ˻Ϊ*/
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> open(const std::string& path) {
+        auto file = std::shared_ptr<MappedFile>(new MappedFile());
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return nullptr; }
+        file->length = st.st_size;
+        if (file->length > 0) {
+            void* p = mmap(nullptr, file->length, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED) return nullptr;
+            file->base = static_cast<const char*>(p);
+            file->mapped = true;
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return nullptr;
+        file->owned.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        file->base = file->owned.data();
+        file->length = file->owned.size();
+#endif
+        return file;
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(base), length);
+#endif
+    }
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile() = default;
+    const char* base = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> owned;
+};
+
+/*洢ӳپԪΪ16λѡȻûȵŲ
+latency[server][user]ķʷʽֲ䣻Ҳֱָӳļеݶ
+*/
+class LatencyMatrix {
+public:
+    using value_type = uint16_t;
+    enum Order { SERVER_MAJOR, USER_MAJOR };
+
+    class Row {
+    public:
+        Row(const value_type* base, size_t stride): base(base), stride(stride) {}
+        int operator[](int user_id) const { return base[user_id * stride]; }
+    private:
+        const value_type* base;
+        size_t stride;
+    };
+
+    LatencyMatrix() = default;
+    /*ʱҪָµĸⲿڴ*/
+    LatencyMatrix(const LatencyMatrix& other) { *this = other; }
+    LatencyMatrix& operator=(const LatencyMatrix& other) {
+        order = other.order;
+        rows = other.rows;
+        cols = other.cols;
+        values = other.values;
+        owner = other.owner;
+        base = owner != nullptr ? other.base : values.data();
+        return *this;
+    }
+
+    void assign(int n_servers, int m_users, Order order = SERVER_MAJOR) {
+        this->order = order;
+        rows = n_servers + 1;
+        cols = m_users + 1;
+        values.assign(rows * cols, 0);
+        base = values.data();
+        owner.reset();
+    }
+
+    /*ʹⲿڴ棨ӳļowner𱣳ָڴЧ*/
+    void attach(std::shared_ptr<const void> owner, const value_type* external, int n_servers, int m_users, Order order) {
+        this->order = order;
+        rows = n_servers + 1;
+        cols = m_users + 1;
+        values.clear();
+        values.shrink_to_fit();
+        base = external;
+        this->owner = std::move(owner);
+    }
+
+    Row operator[](int server_id) const {
+        if (order == SERVER_MAJOR) return Row(base + server_id * cols, 1);
+        return Row(base + server_id, rows);
+    }
+
+    void set(int server_id, int user_id, int v) {
+        assert(owner == nullptr);
+        assert(v >= 0 && v <= std::numeric_limits<value_type>::max());
+        values[index(server_id, user_id)] = v;
+    }
+
+    size_t size() const { return rows; }
+    size_t element_count() const { return rows * cols; }
+    Order layout() const { return order; }
+    const value_type* raw() const { return base; }
+
+private:
+    Order order = SERVER_MAJOR;
+    size_t rows = 0, cols = 0;
+    std::vector<value_type> values;
+    const value_type* base = nullptr;
+    std::shared_ptr<const void> owner;
+
+    size_t index(int server_id, int user_id) const {
+        return order == SERVER_MAJOR ? server_id * cols + user_id : user_id * rows + server_id;
+    }
+};
+
+/*ûֶΰд洢ȵѭ˳ʡ
+ProblemData::users ΨһȨݣֻǶʵ build(users) ɵֻ޸ users  build
+*/
+struct UserColumns {
+    std::vector<int> s, e, cnt, a, b;
+
+    void build(const std::vector<User>& users) {
+        size_t n = users.size();
+        s.resize(n); e.resize(n); cnt.resize(n); a.resize(n); b.resize(n);
+        for (size_t i = 0; i < n; i ++) {
+            s[i] = users[i].s; e[i] = users[i].e; cnt[i] = users[i].cnt;
+            a[i] = users[i].a; b[i] = users[i].b;
+        }
+    }
+
+    /*User::calculate_batchһ*/
+    int calculate_batch(int user_id, int mem) const {
+        return std::max(0, (mem - b[user_id]) / a[user_id]);
+    }
+};
+
 class ProblemData {
 public:
     int n_servers;
     int m_users;
     std::vector<std::vector<NPU>> npus; 
     std::vector<User> users;
-    std::vector<std::vector<int>> latency;
+    UserColumns user_cols;
+    LatencyMatrix latency;
+    /*ıʱӳپŲ--latency-orderʵļм¼Ų*/
+    LatencyMatrix::Order latency_order = LatencyMatrix::SERVER_MAJOR;
 
+    /*һԶٽ*/
     void read(std::istream& in) {
-        in >> n_servers;
+        std::string buffer;
+        char chunk[1 << 16];
+        std::streamsize n;
+        while ((n = in.rdbuf()->sgetn(chunk, sizeof(chunk))) > 0) {
+            buffer.append(chunk, n);
+        }
+        parse(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    /*ڴ룬ӳپзֿ鲢н*/
+    void parse(const char* begin, const char* end) {
+        const char* p = begin;
+        n_servers = next_int(p, end);
         npus.resize(n_servers + 1);
         for (int i = 1; i <= n_servers; ++i) { 
-            int g, k, m; 
-            in >> g >> k >> m;
+            int g = next_int(p, end), k = next_int(p, end), m = next_int(p, end);
             npus[i].resize(g + 1);
             for (int j = 1; j <= g; j++) {
                 npus[i][j].server_id = i;
                 npus[i][j].npu_id = j;
                 npus[i][j].k = k;
                 npus[i][j].memory = m;
+                HandleTimeTable::attach(npus[i][j]);
             }
         }
 
-        in >> m_users;
+        m_users = next_int(p, end);
         users.resize(m_users + 1);
         for (int i = 1; i <= m_users; ++i) { 
             users[i].id = i; 
-            in >> users[i].s >> users[i].e >> users[i].cnt; 
+            users[i].s = next_int(p, end);
+            users[i].e = next_int(p, end);
+            users[i].cnt = next_int(p, end);
         }
 
-        latency.assign(n_servers + 1, std::vector<int>(m_users + 1));
-        for (int i = 1; i <= n_servers; ++i) { 
-            for (int j = 1; j <= m_users; ++j) { 
-                in >> latency[i][j]; 
-            } 
-        }
+        latency.assign(n_servers, m_users, latency_order);
+        p = parse_latency(p, end);
 
         for (int i = 1; i <= m_users; i ++) {
-            std::cin >> users[i].a >> users[i].b;
+            users[i].a = next_int(p, end);
+            users[i].b = next_int(p, end);
         }        
+        user_cols.build(users);
+    }
+
+    /*ԲԴפ󣩵ıʵÿķΧڡ
+    ЩΧʱ䲻6e4bСaΧʵԽ㣻
+    ֻɨ費ڴ棬ͨparseͨʱerror˵һ
+    */
+    static bool check_text(const char* begin, const char* end, std::string& error) {
+        const char* p = begin;
+        auto take = [&](const char* field, long long lo, long long hi, long long& v) {
+            while (p < end && (unsigned)(*p - '0') > 9 && *p != '-') p ++;
+            bool neg = p < end && *p == '-';
+            p += neg;
+            if (p >= end || (unsigned)(*p - '0') > 9) {
+                error = std::string("missing ") + field;
+                return false;
+            }
+            v = 0;
+            // ޺ۼӣv
+            for (; p < end && (unsigned)(*p - '0') <= 9; p ++) if (v <= hi) v = v * 10 + (*p - '0');
+            if (neg) v = -v;
+            if (v < lo || v > hi) {
+                error = std::string(field) + " out of range: " + std::to_string(v);
+                return false;
+            }
+            return true;
+        };
+
+        long long n, m, v;
+        if (!take("N", 1, 10, n)) return false;
+        for (int i = 1; i <= n; i ++) {
+            if (!take("g", 1, 10, v) || !take("k", 1, 5, v) || !take("m", 1000, 2000, v)) return false;
+        }
+        if (!take("M", 1, 500, m)) return false;
+        for (int i = 1; i <= m; i ++) {
+            long long s, e;
+            if (!take("s", 0, 59999, s) || !take("e", s + 1, 60000, e) || !take("cnt", 1, 6000, v)) return false;
+        }
+        for (int i = 0; i < n * m; i ++) {
+            if (!take("latency", 10, 20, v)) return false;
+        }
+        for (int i = 1; i <= m; i ++) {
+            if (!take("a", 10, 20, v) || !take("b", 100, 200, v)) return false;
+        }
+        return true;
+    }
+
+    /*ʵʽСˣ
+    ͷ32ֽڣmagic "NPUBIN01"汾NMӳپŲ
+    N(g, k, m)ûУsecntabMint32
+    뵽64ֽںΪ(N+1)*(M+1)uint16ӳ٣LatencyMatrixһ£±0Ϊռλ
+    */
+    static constexpr char BINARY_MAGIC[9] = "NPUBIN01";
+    static constexpr int32_t BINARY_VERSION = 1;
+    /*ʵÿ̨NPUޣNPUռļռ䣬޷ļԼ*/
+    static constexpr int32_t BINARY_MAX_NPUS_PER_SERVER = 1 << 16;
+
+    bool save_binary(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) return false;
+        std::vector<char> bytes;
+        auto put = [&](const void* p, size_t n) {
+            bytes.insert(bytes.end(), static_cast<const char*>(p), static_cast<const char*>(p) + n);
+        };
+        auto put_i32 = [&](int32_t v) { put(&v, sizeof(v)); };
+        put(BINARY_MAGIC, 8);
+        put_i32(BINARY_VERSION); put_i32(n_servers); put_i32(m_users); put_i32(latency.layout());
+        bytes.resize(32, 0);
+        for (int i = 1; i <= n_servers; i ++) {
+            const NPU& npu = npus[i][npus[i].size() > 1 ? 1 : 0];
+            put_i32((int)npus[i].size() - 1); put_i32(npu.k); put_i32(npu.memory);
+        }
+        for (auto column: {&UserColumns::s, &UserColumns::e, &UserColumns::cnt, &UserColumns::a, &UserColumns::b}) {
+            put((user_cols.*column).data() + 1, sizeof(int32_t) * m_users);
+        }
+        bytes.resize((bytes.size() + 63) / 64 * 64, 0);
+        put(latency.raw(), sizeof(LatencyMatrix::value_type) * latency.element_count());
+        out.write(bytes.data(), bytes.size());
+        return (bool)out;
+    }
+
+    /*ӳʵӳپֱָӳڴ*/
+    bool load_binary(const std::shared_ptr<MappedFile>& file) {
+        const char* p = file->data();
+        size_t length = file->size();
+        if (length < 32 || memcmp(p, BINARY_MAGIC, 8) != 0) return false;
+        int32_t header[4];
+        memcpy(header, p + 8, sizeof(header));
+        if (header[0] != BINARY_VERSION) return false;
+        if (header[1] < 0 || header[2] < 0) return false;
+        if (header[3] != LatencyMatrix::SERVER_MAJOR && header[3] != LatencyMatrix::USER_MAJOR) return false;
+        n_servers = header[1];
+        m_users = header[2];
+        auto order = static_cast<LatencyMatrix::Order>(header[3]);
+
+        /*NMǸҲint32δС64λ㲻ļж*/
+        uint64_t users_offset = 32 + sizeof(int32_t) * 3 * (uint64_t)n_servers;
+        uint64_t latency_offset = (users_offset + sizeof(int32_t) * 5 * (uint64_t)m_users + 63) / 64 * 64;
+        uint64_t latency_bytes = sizeof(LatencyMatrix::value_type) * ((uint64_t)n_servers + 1) * ((uint64_t)m_users + 1);
+        if (latency_offset > length || latency_bytes > length - latency_offset) return false;
+
+        size_t offset = 32;
+        for (int i = 1; i <= n_servers; i ++) {
+            int32_t g;
+            memcpy(&g, p + offset + sizeof(int32_t) * 3 * (i - 1), sizeof(g));
+            if (g < 0 || g > BINARY_MAX_NPUS_PER_SERVER) return false;
+        }
+        npus.assign(n_servers + 1, {});
+        for (int i = 1; i <= n_servers; i ++) {
+            int32_t g_k_m[3];
+            memcpy(g_k_m, p + offset, sizeof(g_k_m));
+            offset += sizeof(g_k_m);
+            npus[i].resize(g_k_m[0] + 1);
+            for (int j = 1; j <= g_k_m[0]; j ++) {
+                npus[i][j] = {i, j, g_k_m[1], g_k_m[2]};
+                HandleTimeTable::attach(npus[i][j]);
+            }
+        }
+
+        /*ļΪsecntabУusersusersи*/
+        auto column = [&](int c, int user_id) {
+            int32_t v;
+            memcpy(&v, p + offset + sizeof(int32_t) * ((size_t)c * m_users + user_id - 1), sizeof(v));
+            return v;
+        };
+        users.assign(m_users + 1, User{});
+        for (int i = 1; i <= m_users; i ++) {
+            users[i] = {i, column(0, i), column(1, i), column(2, i), column(3, i), column(4, i)};
+        }
+        user_cols.build(users);
+
+        latency.attach(file, reinterpret_cast<const LatencyMatrix::value_type*>(p + latency_offset), 
+            n_servers, m_users, order);
+        return true;
+    }
+
+    /*ļԶʶƻıʽ*/
+    bool load_file(const std::string& path) {
+        auto file = MappedFile::open(path);
+        if (file == nullptr) return false;
+        if (file->size() >= 8 && memcmp(file->data(), BINARY_MAGIC, 8) == 0) return load_binary(file);
+        parse(file->data(), file->data() + file->size());
+        return true;
+    }
+
+private:
+    static int next_int(const char*& p, const char* end) {
+        while (p < end && (unsigned)(*p - '0') > 9 && *p != '-') p ++;
+        bool neg = p < end && *p == '-';
+        p += neg;
+        int v = 0;
+        while (p < end && (unsigned)(*p - '0') <= 9) v = v * 10 + (*p ++ - '0');
+        return neg ? -v : v;
+    }
+
+    /*ÿһȰз֣ٶ߳̽Уиʽʱ˻˳*/
+    const char* parse_latency(const char* p, const char* end) {
+        const char* start = p;
+        auto parse_sequential = [&]() {
+            const char* q = start;
+            for (int i = 1; i <= n_servers; ++i) {
+                for (int j = 1; j <= m_users; ++j) latency.set(i, j, next_int(q, end));
+            }
+            return q;
+        };
+        unsigned threads = std::thread::hardware_concurrency();
+        if (threads <= 1 || n_servers < 2 || 1LL * n_servers * m_users < (1 << 16)) return parse_sequential();
+
+        // һʣĻУλÿһеֹ
+        while (p < end && (*p == '\n' || *p == '\r' || *p == ' ')) p ++;
+        std::vector<const char*> line_begin(n_servers + 2, end);
+        line_begin[1] = p;
+        for (int i = 2; i <= n_servers + 1; ++i) {
+            const char* nl = static_cast<const char*>(memchr(line_begin[i - 1], '\n', end - line_begin[i - 1]));
+            if (nl == nullptr) return parse_sequential();
+            line_begin[i] = nl + 1;
+        }
+
+        std::atomic<bool> ok{true};
+        auto parse_rows = [&](int from, int to) {
+            for (int i = from; i < to && ok; ++i) {
+                const char* q = line_begin[i];
+                for (int j = 1; j <= m_users; ++j) latency.set(i, j, next_int(q, end));
+                if (q >= line_begin[i + 1]) ok = false;
+            }
+        };
+        threads = std::min<unsigned>(threads, n_servers);
+        std::vector<std::thread> workers;
+        int rows_per_thread = (n_servers + threads - 1) / threads;
+        for (int from = 1; from <= n_servers; from += rows_per_thread) {
+            workers.emplace_back(parse_rows, from, std::min(n_servers + 1, from + rows_per_thread));
+        }
+        for (auto& w: workers) w.join();
+        if (!ok) return parse_sequential();
+        return line_begin[n_servers + 1];
     }
 };
 
@@ -126,19 +672,90 @@ public:
     virtual ~NPUSimulateModule() = default;
     /*ģ*/
     virtual std::string name() const = 0;
-    /*npuʵͷûģ*/
+    /*npuʵͷûģtokenȡʱǰֹͣδûΪʱ*/
     virtual NpuSimulationResult run(const NPU& npu, const ProblemData& data, 
-        const std::vector<int>& assigned_users) const = 0;
+        const std::vector<int>& assigned_users, const CancellationToken& token) const = 0;
+
+};
+
+
+/*ĹطŵNPUϵֻ󵽴ɵʱµȣ
+а(ʱ, ûid)ηзŵµ󣬴ʱĸ㹫ʽһ¡
+ÿûһbatchʱ
+*/
+class ValidatorQueueModel {
+public:
+    static std::unordered_map<int, int> replay(const NPU& npu, const ProblemData& data,
+        const std::vector<int>& user_ids, const std::vector<std::vector<Schedule> >& schedules) {
+        struct Pending { int arrival, user_id, batch_size; };
+        std::vector<Pending> requests;
+        for (int user_id: user_ids) {
+            int lat = data.latency[npu.server_id][user_id];
+            for (const Schedule& sch: schedules[user_id]) {
+                if (sch.server_id != npu.server_id || sch.npu_id != npu.npu_id) continue;
+                requests.push_back({sch.time + lat, user_id, sch.batch_size});
+            }
+        }
+        std::sort(requests.begin(), requests.end(), [](const Pending& x, const Pending& y) {
+            if (x.arrival != y.arrival) return x.arrival < y.arrival;
+            return x.user_id < y.user_id;
+        });
+
+        using running = std::pair<long long, int>; // (ʱ, ռڴ)
+        std::priority_queue<running, std::vector<running>, std::greater<running> > running_tasks;
+        std::vector<Pending> queue;
+        std::unordered_map<int, int> finish;
+        auto& cols = data.user_cols;
+        int used_memory = 0;
+        size_t next = 0;
+        while (next < requests.size() || !queue.empty()) {
+            long long time = std::numeric_limits<long long>::max();
+            if (next < requests.size()) time = requests[next].arrival;
+            if (!running_tasks.empty()) time = std::min(time, running_tasks.top().first);
+            if (time == std::numeric_limits<long long>::max()) break; // ԶŲµ
+            while (!running_tasks.empty() && running_tasks.top().first == time) {
+                used_memory -= running_tasks.top().second;
+                running_tasks.pop();
+            }
+            while (next < requests.size() && requests[next].arrival == time) queue.push_back(requests[next ++]);
+
+            size_t kept = 0;
+            for (size_t i = 0; i < queue.size(); i ++) {
+                const Pending& req = queue[i];
+                int mem_needed = cols.a[req.user_id] * req.batch_size + cols.b[req.user_id];
+                if (used_memory + mem_needed <= npu.memory) {
+                    used_memory += mem_needed;
+                    long long done = time + validator_time(npu.k, req.batch_size);
+                    running_tasks.push({done, mem_needed});
+                    int& f = finish[req.user_id];
+                    f = std::max<long long>(f, done);
+                } else {
+                    queue[kept ++] = req;
+                }
+            }
+            queue.resize(kept);
+        }
+        return finish;
+    }
 
+private:
+    static long long validator_time(int k, int batch_size) {
+        double inference_speed = (batch_size > 0) ? k * std::sqrt(batch_size) : 1.0;
+        return (inference_speed > 0) ? static_cast<long long>(std::ceil(batch_size / inference_speed)) : 0;
+    }
 };
 
 
-/*ûԶʱ*/
+/*ûԶʱ飻
+exact_queueΪtrueʱ滮ٰŶӹطһ飬ʵʳʱûΪʱ
+*/
 class NPUAutoTimeBlockModule: public NPUSimulateModule {
 public:
-    std::string name() const override { return "NPUAutoTimeBlockModule"; }
+    explicit NPUAutoTimeBlockModule(bool exact_queue = false): exact_queue(exact_queue) {}
+
+    std::string name() const override { return exact_queue ? "NPUAutoTimeBlockModule(exact)" : "NPUAutoTimeBlockModule"; }
     NpuSimulationResult run(const NPU& npu, const ProblemData& data, 
-        const std::vector<int>& assigned_users) const override {
+        const std::vector<int>& assigned_users, const CancellationToken& token) const override {
         LOG("%s module is running!", name().c_str());
 
         // һЩصĶ
@@ -146,7 +763,8 @@ public:
         int max_time = 6e4, server_id = npu.server_id, npu_id = npu.npu_id;
         
         const std::vector<User>& users = data.users;
-        const std::vector<std::vector<int>>& latency = data.latency;
+        const UserColumns& cols = data.user_cols;
+        const LatencyMatrix& latency = data.latency;
 
         // 巵ؽ
         NpuSimulationResult result;
@@ -228,10 +846,10 @@ public:
 
         /*㵱ǰûȼ*/
         auto calculate_priority = [&](int time, int user_id) -> user_prior {
-            int A = users[user_id].a, B = users[user_id].b;
+            int A = cols.a[user_id], B = cols.b[user_id];
             int block_time = npu.calculate_time(B / A);
             int batch_size = (npu.k * block_time) * (npu.k * block_time);
-            return users[user_id].e - calculate_handle_time(user_id, remaining_samples[user_id], batch_size);
+            return cols.e[user_id] - calculate_handle_time(user_id, remaining_samples[user_id], batch_size);
         };
 
         
@@ -263,7 +881,7 @@ public:
             remaining_send_count[user_id] -= 1;
             int handle_time = npu.calculate_time(batch_size);
             if (remaining_samples[user_id] <= 0) {
-                if (time + handle_time <= users[user_id].e) {
+                if (time + handle_time <= cols.e[user_id]) {
                     completed_users.push_back(user_id);
                     remaining_samples.erase(user_id);
                 } else {
@@ -281,23 +899,22 @@ public:
             if (remaining_send_count[user_id] <= 0) return false;
             if (remaining_samples[user_id] > remaining_send_count[user_id] * batch) return false;
             int process_time = calculate_handle_time(user_id, remaining_samples[user_id], batch);
-            return time + 1 * process_time <= users[user_id].e;
+            return time + 1 * process_time <= cols.e[user_id];
         };
 
         auto can_send2 = [&](int time, int user_id, int batch) {
             if (batch <= 0) return false;
             if (remaining_send_count[user_id] <= 0) return false;
-            int A = users[user_id].a, B = users[user_id].b;
             double r1 = big_time[user_id] * big_time[user_id];
             double r2 = small_time[user_id] * small_time[user_id];
             double rate = r2 / (r1 + r2); // ı
             int cnt2 = remaining_send_count[user_id] * rate;
             int cnt1 = remaining_send_count[user_id] - cnt2;
             int big_batch = big_time[user_id] * big_time[user_id] * npu.k * npu.k;
-            big_batch = std::min(big_batch, users[user_id].calculate_batch(memory));
+            big_batch = std::min(big_batch, cols.calculate_batch(user_id, memory));
             if (cnt1 * batch + cnt2 * big_batch < remaining_samples[user_id]) return false;
             int process_time = calculate_handle_time(user_id, remaining_samples[user_id], batch);
-            return time + process_time <= users[user_id].e;
+            return time + process_time <= cols.e[user_id];
         };
 
 
@@ -425,6 +1042,7 @@ public:
         for (int time = 0; time <= max_time; time ++) {
             // LOG("current time: %d, %d", available_users.size(), waiting_users.size());
             if (early_stop) break;
+            if ((time & 1023) == 0 && token.is_cancelled()) break;
             if (available_users.size() == 0 and waiting_users.size() == 0) break;
             update_avaliable_users(time);
             send_strategy(time);
@@ -435,11 +1053,24 @@ public:
             timeout_users.push_back(v.first);
         }
 
+        if (exact_queue && !early_stop) {
+            std::unordered_map<int, int> actual = ValidatorQueueModel::replay(npu, data, assigned_users, schedules);
+            std::vector<int> on_time;
+            for (int user_id: completed_users) {
+                auto it = actual.find(user_id);
+                if (it != actual.end() && it->second <= cols.e[user_id]) on_time.push_back(user_id);
+                else timeout_users.push_back(user_id);
+            }
+            completed_users.swap(on_time);
+        }
+
         LOG("simulate users count:%d, timeout users count: %d", assigned_users.size(), timeout_users.size());
         return result;
 
     }
 
+private:
+    bool exact_queue;
 };
 
 
@@ -459,7 +1090,8 @@ class IteratorModule {
 public:
     virtual ~IteratorModule() = default;
     virtual std::string name() const = 0;
-    virtual IteratorResult run(const ProblemData& data, const NPUSimulateModule& simulator) const = 0;
+    virtual IteratorResult run(const ProblemData& data, const NPUSimulateModule& simulator,
+        const CancellationToken& token) const = 0;
 };
 
 /*ÿʱûnpuжмǷܹ룬
@@ -467,11 +1099,16 @@ public:
 */
 class BruteIteratorModule: public IteratorModule {
 public:
-    std::string name() const override { return "BruteIteratorModule"; }
-    IteratorResult run(const ProblemData& data, const NPUSimulateModule& simulator) const override {
+    /*weightedΪtrueʱû÷Ȩq = 2^(-id/5000)˳
+    fail_fastΪtrueʱֵһ޷ûֹֻͣǷȫʱʹã
+    */
+    explicit BruteIteratorModule(bool weighted = false, bool fail_fast = false): weighted(weighted), fail_fast(fail_fast) {}
+
+    std::string name() const override { return weighted ? "WeightedBruteIteratorModule" : "BruteIteratorModule"; }
+    IteratorResult run(const ProblemData& data, const NPUSimulateModule& simulator,
+        const CancellationToken& token) const override {
         LOG("Running %s...", name().c_str());
         int M = data.m_users, N = data.n_servers;
-        auto& users = data.users;
         auto& npus = data.npus;
         
         IteratorResult result;
@@ -491,19 +1128,18 @@ public:
         }
 
 
-        std::sort(timeout_users.begin(), timeout_users.end(), [&](int u1, int u2) {
-            double u1_pri = users[u1].cnt * users[u1].a + users[u1].b;
-            double u2_pri = users[u2].cnt * users[u2].a + users[u2].b;
-
-            // u1_pri /= std::pow(2.0, -users[u1].id / 5000.0);
-            // u2_pri /= std::pow(2.0, -users[u2].id / 5000.0);
-
-            return u1_pri < u2_pri;
-        });
+        // ûռԴԽԽȳԣԤȰ
+        auto& cols = data.user_cols;
+        std::vector<double> sort_key(M + 1, 0);
+        for (int i = 1; i <= M; i ++) {
+            sort_key[i] = cols.cnt[i] * cols.a[i] + cols.b[i];
+            if (weighted) sort_key[i] /= std::pow(2.0, -i / 5000.0);
+        }
+        auto by_sort_key = [&](int u1, int u2) { return sort_key[u1] < sort_key[u2]; };
+        std::sort(timeout_users.begin(), timeout_users.end(), by_sort_key);
 
 
         LOG("begin iter");
-        auto program_start_time = std::chrono::steady_clock::now();
         int round = 2;
         std::vector<int> r = {1, 1, 1, 1, 1};
         while (round --) {
@@ -514,9 +1150,7 @@ public:
             int max_try_users_count = std::min(100, (int)timeout_users.size());
             while (idx < sz) {
                 bool assign_success = false;
-                auto program_current_time = std::chrono::steady_clock::now();
-                std::chrono::duration<double> elapsed_seconds = program_current_time - program_start_time;
-                if (elapsed_seconds.count() >= MAX_RUN_TIME) break;
+                if (token.is_cancelled()) break;
                 for (int i = 1; i <= data.n_servers; i ++) {
                     if (assign_success) break;
                     for (int j = 1; j < data.npus[i].size(); j ++) {
@@ -525,7 +1159,7 @@ public:
                         int end = std::min(idx + max_try_users_count, (int)timeout_users.size());
                         new_simulate_users.insert(new_simulate_users.end(), 
                             timeout_users.begin() + idx, timeout_users.begin() + end);
-                        NpuSimulationResult res = simulator.run(npus[i][j], data, new_simulate_users);
+                        NpuSimulationResult res = simulator.run(npus[i][j], data, new_simulate_users, token);
                         if (res.timeout_users.size() == 0) {
                             simulate_users[i][j] = new_simulate_users;
                             simulate_results[i][j] = res;
@@ -535,6 +1169,7 @@ public:
                     }
                 }
                 if (max_try_users_count == r[round] and !assign_success) {
+                    if (fail_fast) return result;
                     new_timeout_users.push_back(timeout_users[idx]);
                     idx += r[round];
                     max_try_users_count = r[round];
@@ -547,20 +1182,10 @@ public:
             }
             
             timeout_users = new_timeout_users;
-            std::sort(timeout_users.begin(), timeout_users.end(), [&](int u1, int u2) {
-                double u1_pri = users[u1].cnt * users[u1].a + users[u1].b;
-                double u2_pri = users[u2].cnt * users[u2].a + users[u2].b;
-
-                // u1_pri /= std::pow(2.0, -users[u1].id / 5000.0);
-                // u2_pri /= std::pow(2.0, -users[u2].id / 5000.0);
-
-                return u1_pri < u2_pri;
-            });
+            std::sort(timeout_users.begin(), timeout_users.end(), by_sort_key);
             LOG("this round new success count: %d", success_count);
             if (success_count == 0) break;
-            auto program_current_time = std::chrono::steady_clock::now();
-            std::chrono::duration<double> elapsed_seconds = program_current_time - program_start_time;
-            if (elapsed_seconds.count() >= MAX_RUN_TIME) break;
+            if (token.is_cancelled()) break;
         }
         // assert(round <= 0);
         // bool f1 = (int)timeout_users.size() >= 300;
@@ -569,6 +1194,9 @@ public:
         return result;        
     }
 
+private:
+    bool weighted;
+    bool fail_fast;
 };
 
 
@@ -586,7 +1214,8 @@ class TimeoutHandlerModule {
 public:
     virtual ~TimeoutHandlerModule() = default;
     virtual std::string name() const = 0;
-    virtual SolverResult run(const ProblemData& data, IteratorResult& iteratorResult) const = 0;
+    virtual SolverResult run(const ProblemData& data, IteratorResult& iteratorResult, 
+        const CancellationToken& token) const = 0;
 };
 
 
@@ -596,7 +1225,7 @@ public:
     
     // ڳʱûĴ
     void simulate(const NPU& npu, const ProblemData& data, 
-        std::vector<int>& assigned_users, NpuSimulationResult& result) const {
+        std::vector<int>& assigned_users, NpuSimulationResult& result, const CancellationToken& token) const {
         LOG("%s module is running!", name().c_str());
         // һЩصĶ
         int M = data.m_users, N = data.n_servers, memory = npu.memory;;
@@ -837,10 +1466,41 @@ public:
         }
 
 
+        /*ʱԤʱʣbatchξ緢֤ͣ*/
+        auto flush_remaining = [&](int time) {
+            LOG("handler cancelled at time %d, flush %d users", time, (int)remaining_samples.size());
+            while (!available_users.empty()) {
+                waiting_users.push({time, available_users.top().second});
+                available_users.pop();
+            }
+            while (!waiting_users.empty()) {
+                int t = std::max(time, waiting_users.top().first), user_id = waiting_users.top().second;
+                waiting_users.pop();
+                if (remaining_send_count[user_id] <= 0) continue;
+                int max_batch_size = users[user_id].calculate_batch(memory);
+                if (max_batch_size <= 0) continue;
+                int batch_size = std::min(max_batch_size, remaining_samples[user_id]);
+                int handle_time = npu.calculate_time(batch_size);
+                int m = users[user_id].calculate_memory(batch_size);
+                for (bool fit = false; !fit; ) {
+                    if (t + handle_time >= (int)memory_usage.size()) memory_usage.resize(t + handle_time + 100, 0);
+                    fit = true;
+                    for (int x = t; x < t + handle_time; x ++) {
+                        if (memory_usage[x] + m > memory) { fit = false; t = x + 1; break; }
+                    }
+                }
+                send(t, user_id, batch_size);
+            }
+        };
+
         // ʼģ
         for (int time = finish_time; time <= max_time; time ++) {
             // LOG("current time: %d", time);
             if (available_users.size() == 0 and waiting_users.size() == 0) break;
+            if ((time & 1023) == 0 && token.is_cancelled()) {
+                flush_remaining(time);
+                break;
+            }
             // ¿ɷû
             update_avaliable_users(time);
 
@@ -855,7 +1515,8 @@ public:
     }
     
     
-    SolverResult run(const ProblemData& data, IteratorResult& iteratorResult) const override {
+    SolverResult run(const ProblemData& data, IteratorResult& iteratorResult, 
+        const CancellationToken& token) const override {
         LOG("%s module is running!", name().c_str());
         // ڳʱûķ
         // װbathsizΪ׼ܵĽʱ
@@ -907,7 +1568,7 @@ public:
 
         for (int i = 1; i <= data.n_servers; i ++) {
             for (int j = 1; j < (int)data.npus[i].size(); j ++) {
-                simulate(npus[i][j], data, simulate_timeout_users[i][j], simulate_results[i][j]);
+                simulate(npus[i][j], data, simulate_timeout_users[i][j], simulate_results[i][j], token);
             }
         }
 
@@ -928,6 +1589,175 @@ public:
 };
 
 
+// ===================================================================
+// Compactػඨ
+// ===================================================================
+
+/*ԵȽкĻ࣬ıûNPUķ*/
+class CompactModule {
+public:
+    virtual ~CompactModule() = default;
+    virtual std::string name() const = 0;
+    virtual void run(const ProblemData& data, SolverResult& solverResult, const CancellationToken& token) const = 0;
+};
+
+/*ÿNPUϰʱ˳batchǰŲٳ԰ûbatchϲ
+ֻԴʱߺͷͼԼ㡢ûʱ䲻ʱŽ޸
+*/
+class GreedyShiftCompactModule: public CompactModule {
+public:
+    std::string name() const override { return "GreedyShiftCompactModule"; }
+
+    void run(const ProblemData& data, SolverResult& solverResult, const CancellationToken& token) const override {
+        LOG("%s module is running!", name().c_str());
+        auto& solution = solverResult.solution;
+        if ((int)solution.size() <= data.m_users) return;
+
+        // NPUռûNPUû
+        std::vector<std::vector<std::vector<int> > > npu_users(data.n_servers + 1);
+        for (int i = 1; i <= data.n_servers; i ++) {
+            npu_users[i].resize(data.npus[i].size());
+        }
+        for (int user_id = 1; user_id <= data.m_users; user_id ++) {
+            auto& schedule = solution[user_id];
+            if (schedule.empty()) continue;
+            bool same_npu = true;
+            for (auto& sch: schedule) {
+                if (sch.server_id != schedule[0].server_id || sch.npu_id != schedule[0].npu_id) same_npu = false;
+            }
+            if (!same_npu) continue;
+            std::sort(schedule.begin(), schedule.end(), [](const Schedule& x, const Schedule& y) {
+                return x.time < y.time;
+            });
+            npu_users[schedule[0].server_id][schedule[0].npu_id].push_back(user_id);
+        }
+
+        int shift_count = 0, merge_count = 0;
+        for (int i = 1; i <= data.n_servers; i ++) {
+            for (int j = 1; j < (int)data.npus[i].size(); j ++) {
+                if (npu_users[i][j].empty()) continue;
+                if (token.is_cancelled()) break;
+                compact_npu(data.npus[i][j], data, npu_users[i][j], solution, shift_count, merge_count);
+            }
+        }
+        LOG("compact shift count: %d, merge count: %d", shift_count, merge_count);
+    }
+
+private:
+    void compact_npu(const NPU& npu, const ProblemData& data, const std::vector<int>& assigned_users,
+        std::vector<std::vector<Schedule> >& solution, int& shift_count, int& merge_count) const {
+        auto& users = data.users;
+        int server_id = npu.server_id, memory = npu.memory;
+
+        // ؽԴʱ
+        int max_end = 0;
+        for (auto& user_id: assigned_users) {
+            for (auto& sch: solution[user_id]) {
+                int start = sch.time + data.latency[server_id][user_id];
+                max_end = std::max(max_end, start + npu.calculate_time(sch.batch_size));
+            }
+        }
+        std::vector<int> memory_usage(max_end + 1, 0);
+
+        auto update_memory = [&](int start, int user_id, int batch_size, int sign) {
+            int handle_time = npu.calculate_time(batch_size);
+            int m = users[user_id].calculate_memory(batch_size) * sign;
+            for (int t = start; t < start + handle_time; t ++) memory_usage[t] += m;
+        };
+
+        /*[lower, upper]Ѱܷ¸batchĵʱ䣬Ҳ-1*/
+        auto find_earliest = [&](int lower, int upper, int user_id, int batch_size) {
+            int handle_time = npu.calculate_time(batch_size);
+            int m = users[user_id].calculate_memory(batch_size);
+            if (m > memory) return -1;
+            int t = lower;
+            while (t <= upper) {
+                int conflict = -1;
+                for (int x = t; x < t + handle_time; x ++) {
+                    int used = x < (int)memory_usage.size() ? memory_usage[x] : 0;
+                    if (used + m > memory) { conflict = x; break; }
+                }
+                if (conflict == -1) return t;
+                t = conflict + 1;
+            }
+            return -1;
+        };
+
+        auto ensure_size = [&](int end) {
+            if (end >= (int)memory_usage.size()) memory_usage.resize(end + 1, 0);
+        };
+
+        for (auto& user_id: assigned_users) {
+            int lat = data.latency[server_id][user_id];
+            for (auto& sch: solution[user_id]) update_memory(sch.time + lat, user_id, sch.batch_size, 1);
+        }
+
+        // һԭʱȫǰŲ
+        using item = std::array<int, 3>; // (arrival, user_id, index)
+        std::vector<item> order;
+        for (auto& user_id: assigned_users) {
+            int lat = data.latency[server_id][user_id];
+            for (int idx = 0; idx < (int)solution[user_id].size(); idx ++) {
+                order.push_back({solution[user_id][idx].time + lat, user_id, idx});
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        for (auto& [arrival, user_id, idx]: order) {
+            int lat = data.latency[server_id][user_id];
+            auto& schedule = solution[user_id];
+            int lower = idx == 0 ? users[user_id].s + lat : schedule[idx - 1].time + 2 * lat + 1;
+            if (lower >= arrival) continue;
+            int batch_size = schedule[idx].batch_size;
+            update_memory(arrival, user_id, batch_size, -1);
+            int best = find_earliest(lower, arrival - 1, user_id, batch_size);
+            if (best == -1) best = arrival;
+            else shift_count ++;
+            update_memory(best, user_id, batch_size, 1);
+            schedule[idx].time = best - lat;
+        }
+
+        // ڶԺϲûbatchֻʱϸǰŽ
+        auto finish_of = [&](int user_id) {
+            int lat = data.latency[server_id][user_id], res = 0;
+            for (auto& sch: solution[user_id]) {
+                res = std::max(res, sch.time + lat + npu.calculate_time(sch.batch_size));
+            }
+            return res;
+        };
+
+        for (auto& user_id: assigned_users) {
+            int lat = data.latency[server_id][user_id];
+            auto& schedule = solution[user_id];
+            while (schedule.size() >= 2) {
+                int n = schedule.size();
+                Schedule first = schedule[n - 2], second = schedule[n - 1];
+                int merged = first.batch_size + second.batch_size;
+                if (users[user_id].calculate_memory(merged) > memory) break;
+
+                int old_finish = finish_of(user_id);
+                int lower = n == 2 ? users[user_id].s + lat : schedule[n - 3].time + 2 * lat + 1;
+                update_memory(first.time + lat, user_id, first.batch_size, -1);
+                update_memory(second.time + lat, user_id, second.batch_size, -1);
+                int handle_time = npu.calculate_time(merged);
+                int upper = old_finish - handle_time - 1;
+                int best = upper >= lower ? find_earliest(lower, upper, user_id, merged) : -1;
+                if (best == -1) {
+                    update_memory(first.time + lat, user_id, first.batch_size, 1);
+                    update_memory(second.time + lat, user_id, second.batch_size, 1);
+                    break;
+                }
+                ensure_size(best + handle_time);
+                update_memory(best, user_id, merged, 1);
+                schedule.pop_back();
+                schedule.back() = {best - lat, first.server_id, first.npu_id, merged};
+                merge_count ++;
+            }
+        }
+    }
+};
+
+
 // ===================================================================
 // Solverػඨ
 // ===================================================================
@@ -935,23 +1765,55 @@ public:
 class Solver {
 public:
     virtual std::string name() const = 0;
-    virtual SolverResult solve(ProblemData& data) = 0;
+    virtual SolverResult solve(const ProblemData& data, const TimeBudget& budget, const CancellationToken& token) = 0;
     virtual ~Solver() = default;
 
     static void print_solution(const std::vector<std::vector<Schedule>>& solution, int m_users) {
+        FastWriter out;
+        print_solution(solution, m_users, out);
+    }
+
+    /*ģͣbatchＴʼԤÿûʱ䣬ûûΪ-1*/
+    static std::vector<int> predict_finish_times(const ProblemData& data, const std::vector<std::vector<Schedule>>& solution) {
+        std::vector<int> finish(data.m_users + 1, -1);
+        for (int i = 1; i <= data.m_users && i < (int)solution.size(); ++i) {
+            for (const auto& sch: solution[i]) {
+                const NPU& npu = data.npus[sch.server_id][sch.npu_id];
+                int done = sch.time + data.latency[sch.server_id][i] + npu.calculate_time(sch.batch_size);
+                finish[i] = std::max(finish[i], done);
+            }
+        }
+        return finish;
+    }
+
+    /*ÿһûuser_id predicted_finish_time*/
+    static bool save_predictions(const std::string& path, const ProblemData& data,
+        const std::vector<std::vector<Schedule>>& solution) {
+        std::vector<int> finish = predict_finish_times(data, solution);
+        std::ofstream file(path);
+        if (!file.is_open()) return false;
+        for (int i = 1; i <= data.m_users; ++i) file << i << ' ' << finish[i] << '\n';
+        return (bool)file;
+    }
+
+    static void print_solution(const std::vector<std::vector<Schedule>>& solution, int m_users, FastWriter& out) {
         if (solution.empty() || solution.size() <= 1) return;
         for (int i = 1; i <= m_users; ++i) {
             const auto& user_schedule = solution[i];
             if (user_schedule.empty()) {
-                std::cout << 0 << "\n\n";
+                out.put_char('0'); out.put_char('\n'); out.put_char('\n');
                 continue;
             }
-            std::cout << user_schedule.size() << "\n";
+            out.put_int(user_schedule.size()); out.put_char('\n');
             for (size_t j = 0; j < user_schedule.size(); ++j) {
                 const auto& sch = user_schedule[j];
-                std::cout << sch.time << " " << sch.server_id << " " << sch.npu_id << " " << sch.batch_size << (j == user_schedule.size() - 1 ? "" : " ");
+                out.put_int(sch.time); out.put_char(' ');
+                out.put_int(sch.server_id); out.put_char(' ');
+                out.put_int(sch.npu_id); out.put_char(' ');
+                out.put_int(sch.batch_size);
+                if (j != user_schedule.size() - 1) out.put_char(' ');
             }
-            std::cout << "\n";
+            out.put_char('\n');
         }
     }
 };
@@ -960,34 +1822,1172 @@ public:
 
 class AutoTimeBlockSolver : public Solver {
 public:
-    std::string name() const override { return "AutoTimeBlockSolver"; }
+    /*exact_queueNPUAutoTimeBlockModule*/
+    explicit AutoTimeBlockSolver(bool weighted = false, bool exact_queue = false): weighted(weighted), exact_queue(exact_queue) {}
+
+    std::string name() const override { return weighted ? "WeightedAutoTimeBlockSolver" : "AutoTimeBlockSolver"; }
     
-    SolverResult solve(ProblemData& data) override {
+    SolverResult solve(const ProblemData& data, const TimeBudget& budget, const CancellationToken& token) override {
         LOG("Running %s...", name().c_str());
 
-        NPUAutoTimeBlockModule simulator;
-        BruteIteratorModule iterator;
+        NPUAutoTimeBlockModule simulator(exact_queue);
+        BruteIteratorModule iterator(weighted);
         AutoTimeBlockHandlerModule timeout_handler;
-        IteratorResult iterator_result = iterator.run(data, simulator);
+        GreedyShiftCompactModule compactor;
+        CancellationToken iterate_token(budget.deadline(TimeBudget::ITERATE), &token);
+        CancellationToken handle_token(budget.deadline(TimeBudget::HANDLE), &token);
+        CancellationToken compact_token(budget.deadline(TimeBudget::COMPACT), &token);
+        IteratorResult iterator_result = iterator.run(data, simulator, iterate_token);
+        LOG("iterate phase finished at %.2fs", budget.elapsed());
         
-        return timeout_handler.run(data, iterator_result); 
+        SolverResult result = timeout_handler.run(data, iterator_result, handle_token);
+        LOG("handle phase finished at %.2fs", budget.elapsed());
+        compactor.run(data, result, compact_token);
+        return result;
     }
-};
 
+private:
+    bool weighted;
+    bool exact_queue;
+};
 
 
-// ===================================================================
-// START: Main Function
-// ===================================================================
+/*ڴģԽ⾫ȷ֣Ҫдļ*/
+class ExactEvaluator {
+public:
+    struct Score {
+        bool valid = false;
+        double final_score = 0;
+        int late_users = 0;
+        std::string error;
+    };
 
-int main() {
+    static constexpr bool available() {
+#ifdef HAS_EXACT_EVALUATOR
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static Score evaluate(const ProblemData& data, const std::vector<std::vector<Schedule>>& solution) {
+        Score score;
+#ifdef HAS_EXACT_EVALUATOR
+        try {
+            validator::Simulator simulator;
+            for (int i = 1; i <= data.n_servers; i ++) {
+                const NPU& npu = data.npus[i].size() > 1 ? data.npus[i][1] : NPU{i, 0, 1, 0};
+                simulator.add_server(data.npus[i].size() - 1, npu.k, npu.memory);
+            }
+            auto& cols = data.user_cols;
+            for (int u = 1; u <= data.m_users; u ++) {
+                simulator.add_user(cols.s[u], cols.e[u], cols.cnt[u], cols.a[u], cols.b[u]);
+            }
+            for (int i = 1; i <= data.n_servers; i ++) {
+                auto row = data.latency[i];
+                for (int u = 1; u <= data.m_users; u ++) simulator.set_latency(u, i, row[u]);
+            }
+            for (int u = 1; u <= data.m_users; u ++) {
+                const auto& user_schedule = u < (int)solution.size() ? solution[u] : std::vector<Schedule>();
+                simulator.begin_user_requests(u, user_schedule.size());
+                for (const Schedule& sch: user_schedule) {
+                    simulator.add_request(u, sch.time, sch.server_id, sch.npu_id, sch.batch_size);
+                }
+                simulator.end_user_requests(u);
+            }
+            simulator.run();
+            validator::ScoreSummary summary = simulator.compute_score();
+            score.valid = true;
+            score.final_score = summary.final_score;
+            score.late_users = summary.late_users;
+        } catch (const validator::ValidationError& e) {
+            score.error = e.what();
+        }
+#else
+        (void)data; (void)solution;
+        score.error = "validator.h not available";
+#endif
+        return score;
+    }
+};
+
+
+/*̶̵̳߳߳أפģʽ¿*/
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t n) {
+        for (size_t i = 0; i < n; i ++) {
+            workers.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                        if (stopping && tasks.empty()) return;
+                        task = std::move(tasks.front());
+                        tasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w: workers) w.join();
+    }
+
+    std::future<void> submit(std::function<void()> fn) {
+        auto task = std::make_shared<std::packaged_task<void()> >(std::move(fn));
+        std::future<void> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    size_t size() const { return workers.size(); }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+
+/*ÿһ̲߳Уֹʱ䣬ʱʱŽ*/
+class SolverPortfolio {
+public:
+    struct Result {
+        std::vector<std::vector<Schedule>> best_solution;
+        int max_completed_users = -1;
+        std::string best_solver_name = "None";
+        double best_score = -1; // ȷ֣δʱΪ-1
+    };
+
+    void add(std::unique_ptr<Solver> solver) { solvers.push_back(std::move(solver)); }
+
+    /*poolǿʱ̳߳УΪÿ̡߳
+    жܾȷʱյ÷ѡ񣬷Ԥ׼ʱûѡ
+    */
+    Result run(const ProblemData& data, const TimeBudget& budget, CancellationToken& token, ThreadPool* pool = nullptr) {
+        Result best;
+        std::mutex best_mutex;
+        bool exact = ExactEvaluator::available() && solvers.size() > 1;
+
+        auto run_one = [&](Solver& solver) {
+            LOG("--- Running Solver: %s ---", solver.name().c_str());
+            SolverResult result = solver.solve(data, budget, token);
+            LOG("--- [Result] Solver: %s | Predicted Completed Users: %d ---", 
+                solver.name().c_str(), result.completed_user_count);
+            double score = -1;
+            if (exact) {
+                ExactEvaluator::Score s = ExactEvaluator::evaluate(data, result.solution);
+                if (s.valid) score = s.final_score;
+                LOG("--- [Exact] Solver: %s | Score: %.4f | Late: %d %s ---",
+                    solver.name().c_str(), s.final_score, s.late_users, s.error.c_str());
+            }
+
+            std::lock_guard<std::mutex> lock(best_mutex);
+            bool better = best.max_completed_users < 0 ||
+                (exact ? score > best.best_score : result.completed_user_count > best.max_completed_users);
+            if (better) {
+                LOG("!!! New Best Solution Found! Previous best: %d users.", best.max_completed_users);
+                best.max_completed_users = result.completed_user_count;
+                best.best_solution = std::move(result.solution);
+                best.best_solver_name = solver.name();
+                best.best_score = score;
+            }
+            // û׼ʱɣûмıҪ
+            if (best.max_completed_users >= data.m_users) token.cancel();
+        };
+
+        if (solvers.size() == 1) {
+            run_one(*solvers[0]);
+            return best;
+        }
+
+        if (pool != nullptr) {
+            std::vector<std::future<void> > futures;
+            for (auto& solver: solvers) {
+                Solver* s = solver.get();
+                futures.push_back(pool->submit([&run_one, s]() { run_one(*s); }));
+            }
+            for (auto& f: futures) f.get();
+            return best;
+        }
+
+        std::vector<std::thread> threads;
+        for (auto& solver: solvers) {
+            threads.emplace_back(run_one, std::ref(*solver));
+        }
+        for (auto& t: threads) t.join();
+        return best;
+    }
+
+    size_t size() const { return solvers.size(); }
+
+    /*Ĭϵϣ˻ϲֻụռʱ䣬ʱżԣ
+    allow_variantsΪfalseʱֻûʵѾռкˣ
+    */
+    static SolverPortfolio make_default(bool allow_variants = true, bool exact_queue = false) {
+        SolverPortfolio portfolio;
+        portfolio.add(std::make_unique<AutoTimeBlockSolver>(false, exact_queue));
+        if (allow_variants && std::thread::hardware_concurrency() > 1) {
+            portfolio.add(std::make_unique<AutoTimeBlockSolver>(true, exact_queue));
+        }
+        return portfolio;
+    }
+
+private:
+    std::vector<std::unique_ptr<Solver>> solvers;
+};
+
+
+
+// ===================================================================
+// Boundض
+// ===================================================================
+
+/*׼ʱûϽ磬ŻжԶ
+ɳڷʽNPUÿʱṩ memory ڴ棬һbatchռ (a*b+B) ڴ t(b) ʱ̣
+ûuڷi cnt * min_b((a*b+B)*t(b)/b) / memory "NPUʱ"
+ȡзеСֵw_uֻ [s+Сӳ, e] ڡ
+[t1, t2]ȫڵûĲ NPU*(t2-t1)
+wС̰ļ׼ʱûϴڲڵûһϽ磬
+ɺѡȡС
+*/
+class RelaxationBoundModule {
+public:
+    struct Result {
+        int upper_bound = 0;
+        int infeasible_alone = 0; // ʹռNPUҲ޷׼ʱɵû
+    };
+
+    Result run(const ProblemData& data) const {
+        Result result;
+        int M = data.m_users;
+        auto& cols = data.user_cols;
+        long long total_npus = 0;
+        for (int i = 1; i <= data.n_servers; i ++) total_npus += data.npus[i].size() - 1;
+
+        std::vector<double> w(M + 1, std::numeric_limits<double>::infinity());
+        std::vector<long long> release(M + 1, std::numeric_limits<long long>::max());
+        std::vector<int> feasible_users;
+        for (int u = 1; u <= M; u ++) {
+            for (int i = 1; i <= data.n_servers; i ++) {
+                if (data.npus[i].size() <= 1) continue;
+                const NPU& npu = data.npus[i][1];
+                int lat = data.latency[i][u];
+                int max_batch = std::min(cols.cnt[u], cols.calculate_batch(u, npu.memory));
+                if (max_batch <= 0) continue;
+                long long batches = (cols.cnt[u] + max_batch - 1) / max_batch;
+                if (batches > 300) continue;
+                // ηټlat+1һbatchٻҪ1ʱ
+                long long earliest_finish = cols.s[u] + (batches - 1) * (lat + 1) + lat + 1;
+                if (earliest_finish > cols.e[u]) continue;
+                w[u] = std::min(w[u], (double)cols.cnt[u] * min_area_per_sample(npu, cols.a[u], cols.b[u], max_batch) / npu.memory);
+                release[u] = std::min(release[u], (long long)cols.s[u] + lat);
+            }
+            if (release[u] == std::numeric_limits<long long>::max()) result.infeasible_alone ++;
+            else feasible_users.push_back(u);
+        }
+
+        std::sort(feasible_users.begin(), feasible_users.end(), [&](int u1, int u2) { return w[u1] < w[u2]; });
+        std::vector<long long> releases, deadlines;
+        for (int u: feasible_users) {
+            releases.push_back(release[u]);
+            deadlines.push_back(cols.e[u]);
+        }
+        std::vector<long long> starts = sample_quantiles(releases), ends = sample_quantiles(deadlines);
+
+        int best = feasible_users.size();
+        for (long long t1: starts) {
+            for (long long t2: ends) {
+                if (t2 <= t1) continue;
+                double capacity = (double)total_npus * (t2 - t1);
+                int inside = 0, fit = 0;
+                double used = 0;
+                for (int u: feasible_users) {
+                    if (release[u] < t1 || cols.e[u] > t2) continue;
+                    inside ++;
+                    if (used + w[u] <= capacity) {
+                        used += w[u];
+                        fit ++;
+                    }
+                }
+                best = std::min(best, (int)feasible_users.size() - inside + fit);
+            }
+        }
+        result.upper_bound = best;
+        return result;
+    }
+
+private:
+    /*t(b)ͬʱbԽλԽСֻÿtֵӦb*/
+    static double min_area_per_sample(const NPU& npu, int a, int b, int max_batch) {
+        double best = std::numeric_limits<double>::infinity();
+        int max_t = npu.calculate_time(max_batch);
+        for (int t = 1; t <= max_t; t ++) {
+            long long batch = std::min<long long>(max_batch, (long long)t * npu.k * t * npu.k);
+            if (npu.calculate_time(batch) != t) continue;
+            best = std::min(best, (double)(a * batch + b) * t / batch);
+        }
+        return best;
+    }
+
+    /*ѡ˵㣺ȥغȼȡ64*/
+    static std::vector<long long> sample_quantiles(std::vector<long long> values) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        const size_t limit = 64;
+        if (values.size() <= limit) return values;
+        std::vector<long long> sampled;
+        for (size_t i = 0; i < limit; i ++) sampled.push_back(values[i * (values.size() - 1) / (limit - 1)]);
+        return sampled;
+    }
+};
+
+
+// ===================================================================
+// Onlineض
+// ===================================================================
+
+/*ߵȣûs˳ʱѡNPUȷȫͼƻ
+ÿNPUάһԴʱߣÿѡNPṴķøûbatchѡʱNPU
+ҵһеNPU֮󣬳decision_budgetʱֹNPUֻNPUѡ
+ѡкֱύʱõļƻ·áNPUŲ¸ûbatchʱãscheduleΪգ
+*/
+class OnlineScheduler {
+public:
+    struct Decision {
+        int user_id;
+        int finish_time;
+        std::vector<Schedule> schedule;
+    };
+
+    OnlineScheduler(const std::vector<std::vector<NPU>>& npus, std::chrono::microseconds decision_budget)
+        : decision_budget(decision_budget) {
+        for (size_t i = 1; i < npus.size(); i ++) {
+            for (size_t j = 1; j < npus[i].size(); j ++) {
+                slots.push_back({npus[i][j], {}});
+            }
+        }
+    }
+
+    /*userlatencyŸ±0ʹ*/
+    Decision place(const User& user, const std::vector<int>& latency) {
+        auto deadline = std::chrono::steady_clock::now() + decision_budget;
+        Decision best{user.id, INT_MAX, {}};
+        int best_slot = -1;
+        int n = slots.size();
+        for (int step = 0; step < n; step ++) {
+            int idx = (next_slot + step) % n;
+            std::vector<Schedule> schedule;
+            // ûпзʱֹûΪԤ޴ɷ
+            auto plan_deadline = best_slot == -1 ? std::chrono::steady_clock::time_point::max() : deadline;
+            int finish = plan(slots[idx], user, latency[slots[idx].npu.server_id], schedule, plan_deadline);
+            if (finish < best.finish_time) {
+                best.finish_time = finish;
+                best.schedule = std::move(schedule);
+                best_slot = idx;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) break;
+        }
+        next_slot = (next_slot + 1) % std::max(n, 1);
+        if (best_slot != -1) commit(slots[best_slot], user, latency[slots[best_slot].npu.server_id], best.schedule);
+        return best;
+    }
+
+private:
+    struct Slot {
+        NPU npu;
+        std::vector<int> memory_usage;
+    };
+
+    std::vector<Slot> slots;
+    int next_slot = 0;
+    std::chrono::microseconds decision_budget;
+
+    /*slot̰ķûbatchдƻʱ䣬Դʱڷǰָԭ
+    Ų»򳬹deadlineʱINT_MAX
+    */
+    int plan(Slot& slot, const User& user, int lat, std::vector<Schedule>& schedule,
+        std::chrono::steady_clock::time_point deadline) const {
+        const NPU& npu = slot.npu;
+        auto& memory_usage = slot.memory_usage;
+        int max_batch_size = user.calculate_batch(npu.memory);
+        if (max_batch_size <= 0) return INT_MAX;
+
+        // NPUAutoTimeBlockModulesmall_timeһ£ѡλԴʱߵĿ
+        double best_util = 0;
+        int batch_size = 1;
+        for (int t = 1; t <= 16; t ++) {
+            int time_batch_size = std::min(npu.k * npu.k * t * t, max_batch_size);
+            double util = 1.0 * time_batch_size / user.calculate_memory(time_batch_size) / t;
+            if (util > best_util) {
+                best_util = util;
+                batch_size = time_batch_size;
+            }
+            if (time_batch_size >= max_batch_size) break;
+        }
+        batch_size = std::max(batch_size, (user.cnt + 299) / 300);
+        if (batch_size > max_batch_size) return INT_MAX;
+
+        int remaining = user.cnt, arrival = user.s + lat, finish = 0;
+        std::vector<std::array<int, 3> > placed; // (start, handle_time, memory)
+        auto undo = [&]() {
+            for (auto& [t, handle_time, m]: placed) {
+                for (int x = t; x < t + handle_time; x ++) memory_usage[x] -= m;
+            }
+        };
+        bool timed = deadline != std::chrono::steady_clock::time_point::max();
+        int attempts = 0;
+        while (remaining > 0) {
+            int b = std::min(batch_size, remaining);
+            int handle_time = npu.calculate_time(b), m = user.calculate_memory(b);
+            int t = arrival;
+            for (bool fit = false; !fit; ) {
+                // ÿ256γԼһʱ䣬ʱӵĿԺ
+                if (timed && (++ attempts & 255) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                    undo();
+                    return INT_MAX;
+                }
+                if (t + handle_time >= (int)memory_usage.size()) memory_usage.resize(t + handle_time + 1024, 0);
+                fit = true;
+                for (int x = t; x < t + handle_time; x ++) {
+                    if (memory_usage[x] + m > npu.memory) { fit = false; t = x + 1; break; }
+                }
+            }
+            for (int x = t; x < t + handle_time; x ++) memory_usage[x] += m;
+            placed.push_back({t, handle_time, m});
+            schedule.push_back({t - lat, npu.server_id, npu.npu_id, b});
+            finish = std::max(finish, t + handle_time);
+            remaining -= b;
+            arrival = t + lat + 1;
+        }
+        undo();
+        return finish;
+    }
+
+    /*planõļƻռԴʱ*/
+    void commit(Slot& slot, const User& user, int lat, const std::vector<Schedule>& schedule) const {
+        auto& memory_usage = slot.memory_usage;
+        for (const Schedule& sch: schedule) {
+            int t = sch.time + lat, handle_time = slot.npu.calculate_time(sch.batch_size);
+            int m = user.calculate_memory(sch.batch_size);
+            for (int x = t; x < t + handle_time; x ++) memory_usage[x] += m;
+        }
+    }
+};
+
+/*ͳÿξߺʱstderr*/
+struct DecisionLatencyStats {
+    std::vector<double> samples_us;
+
+    void add(std::chrono::steady_clock::duration d) {
+        samples_us.push_back(std::chrono::duration<double, std::micro>(d).count());
+    }
+
+    void report() const {
+        if (samples_us.empty()) return;
+        std::vector<double> v = samples_us;
+        std::sort(v.begin(), v.end());
+        auto pct = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * v.size()))]; };
+        double mean = std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+        fprintf(stderr, "Decisions: %zu | mean %.1fus | p50 %.1fus | p99 %.1fus | max %.1fus\n",
+            v.size(), mean, pct(0.5), pct(0.99), v.back());
+    }
+};
+
+/*ģʽinÿһû "id s e cnt a b lat_1 ... lat_N"
+ÿξߺ "id T" ԼûķͼƻûNPUŵ¸ûʱ "id UNPLACED" һУ
+stderr˵
+*/
+int run_online(std::istream& in, std::chrono::microseconds decision_budget) {
+    int n_servers;
+    if (!(in >> n_servers)) return 1;
+    std::vector<std::vector<NPU>> npus(n_servers + 1);
+    for (int i = 1; i <= n_servers; i ++) {
+        int g, k, m;
+        in >> g >> k >> m;
+        npus[i].resize(g + 1);
+        for (int j = 1; j <= g; j ++) {
+            npus[i][j] = {i, j, k, m};
+            HandleTimeTable::attach(npus[i][j]);
+        }
+    }
+
+    OnlineScheduler scheduler(npus, decision_budget);
+    DecisionLatencyStats stats;
+    FastWriter out;
+    User user;
+    std::vector<int> latency(n_servers + 1, 0);
+    while (in >> user.id >> user.s >> user.e >> user.cnt >> user.a >> user.b) {
+        for (int i = 1; i <= n_servers; i ++) in >> latency[i];
+        auto begin = std::chrono::steady_clock::now();
+        OnlineScheduler::Decision decision = scheduler.place(user, latency);
+        stats.add(std::chrono::steady_clock::now() - begin);
+
+        if (decision.schedule.empty()) {
+            fprintf(stderr, "User %d: no NPU can hold its batches within 300 sends\n", decision.user_id);
+            out.put_int(decision.user_id);
+            for (const char* c = " UNPLACED\n"; *c; c ++) out.put_char(*c);
+            out.flush();
+            continue;
+        }
+        out.put_int(decision.user_id); out.put_char(' ');
+        out.put_int(decision.schedule.size()); out.put_char('\n');
+        for (size_t j = 0; j < decision.schedule.size(); j ++) {
+            const auto& sch = decision.schedule[j];
+            out.put_int(sch.time); out.put_char(' ');
+            out.put_int(sch.server_id); out.put_char(' ');
+            out.put_int(sch.npu_id); out.put_char(' ');
+            out.put_int(sch.batch_size);
+            if (j != decision.schedule.size() - 1) out.put_char(' ');
+        }
+        out.put_char('\n');
+        out.flush();
+    }
+    stats.report();
+    return 0;
+}
+
+/*ʵطģʽûsε󰴳ʽȫ⣬֤*/
+int run_online_replay(const ProblemData& data, std::chrono::microseconds decision_budget) {
+    std::vector<int> order(data.m_users);
+    std::iota(order.begin(), order.end(), 1);
+    std::stable_sort(order.begin(), order.end(), [&](int u1, int u2) { return data.users[u1].s < data.users[u2].s; });
+
+    OnlineScheduler scheduler(data.npus, decision_budget);
+    DecisionLatencyStats stats;
+    std::vector<std::vector<Schedule>> solution(data.m_users + 1);
+    std::vector<int> latency(data.n_servers + 1, 0);
+    int on_time = 0;
+    std::vector<int> unplaced;
+    for (int user_id: order) {
+        for (int i = 1; i <= data.n_servers; i ++) latency[i] = data.latency[i][user_id];
+        auto begin = std::chrono::steady_clock::now();
+        OnlineScheduler::Decision decision = scheduler.place(data.users[user_id], latency);
+        stats.add(std::chrono::steady_clock::now() - begin);
+        if (decision.schedule.empty()) unplaced.push_back(user_id);
+        on_time += decision.finish_time <= data.users[user_id].e;
+        solution[user_id] = std::move(decision.schedule);
+    }
+    fprintf(stderr, "Online replay predicted on-time users: %d / %d\n", on_time, data.m_users);
+    stats.report();
+    // ûûκηͼƻʱдϷĽ⣨T_iΪ1ֻЩû
+    if (!unplaced.empty()) {
+        fprintf(stderr, "Unplaced users (no NPU can hold their batches within 300 sends): %zu\n", unplaced.size());
+        for (int user_id: unplaced) fprintf(stderr, " %d", user_id);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    Solver::print_solution(solution, data.m_users);
+    return 0;
+}
+
+
+// ===================================================================
+// Daemonض
+// ===================================================================
+
+#ifndef _WIN32
+/*פģʽ֡Э飺Ϊ "\n" ϸóȵʵıӦΪ "\n" ϳʽĽ⣻
+ʵϷʧʱӦΪ "ERROR ԭ\n"ӱֿã
+Ϊ0ʾرշ񣬳ȳ MAX_FRAME_SIZE Ϊʽ
+*/
+class FrameChannel {
+public:
+    /*֡ޣԶģʵı*/
+    static constexpr size_t MAX_FRAME_SIZE = 256u << 20;
+
+    FrameChannel(int in_fd, int out_fd): in_fd(in_fd), out_fd(out_fd), buffer(1 << 16) {}
+
+    /*ȡһ֡ӹرջʽʱfalse÷رո*/
+    bool read_frame(std::string& payload) {
+        size_t length = 0;
+        char c;
+        bool has_digit = false;
+        while (true) {
+            if (!read_exact(&c, 1)) return false;
+            if (c == '\n') break;
+            if (c == '\r' || c == ' ') continue;
+            if (c < '0' || c > '9') return false;
+            length = length * 10 + (c - '0');
+            has_digit = true;
+            // λ飬Ȳ
+            if (length > MAX_FRAME_SIZE) {
+                fprintf(stderr, "Rejected frame: length exceeds %zu bytes\n", MAX_FRAME_SIZE);
+                return false;
+            }
+        }
+        if (!has_digit) return false;
+        payload.resize(length);
+        return read_exact(&payload[0], length);
+    }
+
+    bool write_frame(const std::string& payload) {
+        std::string header = std::to_string(payload.size()) + "\n";
+        return write_all(header.data(), header.size()) && write_all(payload.data(), payload.size());
+    }
+
+private:
+    int in_fd, out_fd;
+    std::vector<char> buffer;
+    size_t begin = 0, end = 0;
+
+    bool read_exact(char* out, size_t n) {
+        while (n > 0) {
+            if (begin == end) {
+                ssize_t got = ::read(in_fd, buffer.data(), buffer.size());
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) return false;
+                begin = 0;
+                end = got;
+            }
+            size_t take = std::min(n, end - begin);
+            memcpy(out, buffer.data() + begin, take);
+            begin += take;
+            out += take;
+            n -= take;
+        }
+        return true;
+    }
+
+    bool write_all(const char* p, size_t n) {
+        while (n > 0) {
+            ssize_t done = ::write(out_fd, p, n);
+            if (done < 0 && errno == EINTR) continue;
+            if (done <= 0) return false;
+            p += done;
+            n -= done;
+        }
+        return true;
+    }
+};
+
+/*פ̳߳ءϡʱԼ/Ӧ/ʵĻ֮临ã
+ÿֻ½ʵ
+*/
+class SolveDaemon {
+public:
+    SolveDaemon(const TimeBudget& budget, bool exact_queue)
+        : budget(budget), portfolio(SolverPortfolio::make_default(true, exact_queue)), pool(std::max<size_t>(1, portfolio.size())) {}
+
+    /*һϵյرʱtrue*/
+    bool serve(FrameChannel& channel) {
+        while (channel.read_frame(request)) {
+            if (request.empty()) return true;
+            auto start = std::chrono::steady_clock::now();
+            std::string error;
+            // һֻظ֡Ӱ
+            try {
+                if (ProblemData::check_text(request.data(), request.data() + request.size(), error)) solve(start);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+            if (!error.empty()) {
+                response = "ERROR " + error + "\n";
+                fprintf(stderr, "Request %d rejected: %s\n", ++ request_count, error.c_str());
+                if (!channel.write_frame(response)) return false;
+                continue;
+            }
+            if (!channel.write_frame(response)) return false;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            fprintf(stderr, "Request %d: M=%d, %.4f seconds\n", ++ request_count, data.m_users, elapsed.count());
+        }
+        return false;
+    }
+
+private:
+    TimeBudget budget;
+    SolverPortfolio portfolio;
+    ThreadPool pool;
+    ProblemData data;
+    std::string request, response;
+    int request_count = 0;
+
+    void solve(std::chrono::steady_clock::time_point start) {
+        data.parse(request.data(), request.data() + request.size());
+        TimeBudget request_budget = budget.restarted(start);
+        CancellationToken token(request_budget.deadline(TimeBudget::COMPACT));
+        SolverPortfolio::Result best = portfolio.run(data, request_budget, token, &pool);
+        response.clear();
+        FastWriter out(&response);
+        Solver::print_solution(best.best_solution, data.m_users, out);
+        out.flush();
+    }
+};
+
+/*׼ϵĳפ*/
+int run_daemon_stdio(const TimeBudget& budget, bool exact_queue) {
+    signal(SIGPIPE, SIG_IGN);
+    SolveDaemon daemon(budget, exact_queue);
+    FrameChannel channel(0, 1);
+    daemon.serve(channel);
+    return 0;
+}
+
+/*Unix׽ϵĳפδÿ*/
+int run_daemon_socket(const std::string& path, const TimeBudget& budget, bool exact_queue) {
+    signal(SIGPIPE, SIG_IGN);
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) { perror("socket"); return 1; }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) { fprintf(stderr, "Socket path too long\n"); return 1; }
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 16) != 0) {
+        perror("bind");
+        close(listen_fd);
+        return 1;
+    }
+
+    SolveDaemon daemon(budget, exact_queue);
+    bool stopping = false;
+    while (!stopping) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        FrameChannel channel(fd, fd);
+        stopping = daemon.serve(channel);
+        close(fd);
+    }
+    close(listen_fd);
+    unlink(path.c_str());
+    return 0;
+}
+#endif
+
+
+// ===================================================================
+// Capacityض
+// ===================================================================
+
+/*滮ÿڴ浵λԭڴϵʹû׼ʱɵNPUã
+õģ+NPUģжϣȫûɹУ
+NPUڴ󲻻
+1. ȶзͬNPUԴΪָ÷NPUֵǰֵ
+   õÿ̨NPU½õǾֲСã֤NPUȫ
+2. ÿζڶ߳ʱÿֲ̽
+3. ڴ浵λСǰһͳһNPUĽǺһϽ
+ÿֻ̽ probe_time ʱ䣨--plan-probe-timeʹԤ㣬ʱ̽ⰴд
+ÿвλһʵ̽ʱֻؽеNPUӳپûвٿ
+*/
+class CapacityPlanner {
+public:
+    struct Point {
+        double memory_scale;
+        int min_npus_per_server = -1;       // зͬʱNPU-1ʾڲ
+        std::vector<int> npus_by_server;     // NPU±0ʹãʱΪ
+        int completed_users = 0;             // õ̽ʱ׼ʱɵû
+        int probes = 0;
+
+        int total_npus() const { return std::accumulate(npus_by_server.begin(), npus_by_server.end(), 0); }
+    };
+
+    CapacityPlanner(const ProblemData& data, std::chrono::duration<double> probe_time, ThreadPool& pool)
+        : data(data), probe_time(probe_time), pool(pool), variants(std::max<size_t>(1, pool.size()), data) {}
+
+    static int scaled_memory(int memory, double scale) {
+        return std::max(1, (int)std::floor(memory * scale));
+    }
+
+    std::vector<Point> run(const std::vector<double>& memory_scales, int max_npus_per_server) {
+        std::vector<double> scales = memory_scales;
+        std::sort(scales.begin(), scales.end());
+        std::vector<Point> curve;
+        int upper = max_npus_per_server;
+        bool upper_known_feasible = false;
+        for (double scale: scales) {
+            Point point;
+            point.memory_scale = scale;
+            if (!all_users_fit(scale)) {
+                // ûһŲ£NPUҲ޼
+                curve.push_back(point);
+                continue;
+            }
+
+            auto uniform = [&](int count, ProblemData& variant) {
+                return probe(std::vector<int>(data.n_servers + 1, count), scale, variant);
+            };
+            int hi_completed = -1;
+            if (!upper_known_feasible) {
+                int completed = uniform(upper, variants[0]);
+                point.probes ++;
+                if (completed < data.m_users) {
+                    point.completed_users = completed;
+                    curve.push_back(point);
+                    continue;
+                }
+                hi_completed = completed;
+            }
+            int g = bisect(1, upper, uniform, hi_completed, point.probes);
+            point.min_npus_per_server = g;
+
+            std::vector<int> counts(data.n_servers + 1, g);
+            for (int i = 1; i <= data.n_servers && g > 1; i ++) {
+                auto on_server = [&](int count, ProblemData& variant) {
+                    std::vector<int> changed = counts;
+                    changed[i] = count;
+                    return probe(changed, scale, variant);
+                };
+                counts[i] = bisect(1, counts[i], on_server, hi_completed, point.probes);
+            }
+            counts[0] = 0;
+            point.npus_by_server = counts;
+            point.completed_users = hi_completed < 0 ? data.m_users : hi_completed;
+            curve.push_back(point);
+            upper = g;
+            upper_known_feasible = true;
+        }
+        return curve;
+    }
+
+private:
+    const ProblemData& data;
+    std::chrono::duration<double> probe_time;
+    ThreadPool& pool;
+    std::vector<ProblemData> variants; // ÿвλһݣͬһеiѡʹvariants[i]
+
+    /*[lo, hi]жСĿֵhi֪Уcompleted_at(x, variant)x׼ʱɵû
+    hi_completedΪֵĽδ̽ʱֲ䣩probesۼ̽
+    */
+    int bisect(int lo, int hi, const std::function<int(int, ProblemData&)>& completed_at, int& hi_completed, int& probes) {
+        // ʽhiУlo-1УloΪ1
+        while (lo < hi) {
+            int width = std::min<int>(variants.size(), hi - lo);
+            std::vector<int> candidates;
+            for (int i = 1; i <= width; i ++) {
+                candidates.push_back(lo + (long long)(hi - lo) * i / (width + 1));
+            }
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            std::vector<int> completed(candidates.size());
+            std::vector<std::future<void> > futures;
+            for (size_t i = 0; i < candidates.size(); i ++) {
+                futures.push_back(pool.submit([&, i]() { completed[i] = completed_at(candidates[i], variants[i]); }));
+            }
+            for (auto& f: futures) f.get();
+            probes += candidates.size();
+
+            int new_lo = lo, new_hi = hi;
+            for (size_t i = 0; i < candidates.size(); i ++) {
+                if (completed[i] >= data.m_users) {
+                    if (candidates[i] < new_hi) { new_hi = candidates[i]; hi_completed = completed[i]; }
+                } else {
+                    new_lo = std::max(new_lo, candidates[i] + 1);
+                }
+            }
+            // ԲʱʽԽСĿеΪ׼
+            if (new_lo > new_hi) new_lo = new_hi;
+            lo = new_lo; hi = new_hi;
+        }
+        return hi;
+    }
+
+    bool all_users_fit(double scale) const {
+        int max_memory = 0;
+        for (int i = 1; i <= data.n_servers; i ++) {
+            if (data.npus[i].size() > 1) max_memory = std::max(max_memory, scaled_memory(data.npus[i][1].memory, scale));
+        }
+        auto& cols = data.user_cols;
+        for (int u = 1; u <= data.m_users; u ++) {
+            if (cols.a[u] + cols.b[u] > max_memory) return false;
+        }
+        return true;
+    }
+
+    /*variantķiΪnpus_by_server[i]NPUڴ水scaleź󣬷ص׶׼ʱɵû
+    ޷ûʱֹͣʱСm_usersΪСvariantಿdataͬᱻ޸
+    */
+    int probe(const std::vector<int>& npus_by_server, double scale, ProblemData& variant) const {
+        for (int i = 1; i <= variant.n_servers; i ++) {
+            int k = data.npus[i].size() > 1 ? data.npus[i][1].k : 1;
+            int memory = data.npus[i].size() > 1 ? scaled_memory(data.npus[i][1].memory, scale) : 1;
+            variant.npus[i].assign(npus_by_server[i] + 1, NPU());
+            for (int j = 1; j <= npus_by_server[i]; j ++) {
+                NPU& npu = variant.npus[i][j];
+                npu.server_id = i;
+                npu.npu_id = j;
+                npu.k = k;
+                npu.memory = memory;
+                HandleTimeTable::attach(npu);
+            }
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(probe_time);
+        CancellationToken token(deadline);
+        NPUAutoTimeBlockModule simulator;
+        BruteIteratorModule iterator(false, true);
+        IteratorResult result = iterator.run(variant, simulator, token);
+        int completed = 0;
+        std::string counts;
+        for (int i = 1; i <= variant.n_servers; i ++) {
+            for (int j = 1; j <= npus_by_server[i]; j ++) completed += result.simulate_users[i][j].size();
+            counts += (i > 1 ? "," : "") + std::to_string(npus_by_server[i]);
+        }
+        LOG("probe npus=%s scale=%.2f completed=%d", counts.c_str(), scale, completed);
+        return completed;
+    }
+};
+
+int run_capacity_plan(const ProblemData& data, double probe_seconds, int threads,
+    const std::string& scales_spec, int max_npus_per_server) {
+    std::vector<double> scales;
+    std::stringstream ss(scales_spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char* end = nullptr;
+        double v = std::strtod(item.c_str(), &end);
+        if (end != item.c_str() && v > 0) scales.push_back(v);
+    }
+    if (scales.empty() || max_npus_per_server <= 0 || !(probe_seconds > 0)) {
+        fprintf(stderr, "Invalid capacity plan arguments\n");
+        return 1;
+    }
+
+    ThreadPool pool(std::max(1, threads));
+    CapacityPlanner planner(data, std::chrono::duration<double>(probe_seconds), pool);
+    std::vector<CapacityPlanner::Point> curve = planner.run(scales, max_npus_per_server);
+
+    printf("%-14s %-28s %-20s %-24s %-12s %-8s\n", "Memory Scale", "Memory Per Server", "Min NPUs Per Server",
+        "NPUs By Server", "Total NPUs", "Probes");
+    printf("%s\n", std::string(111, '-').c_str());
+    for (auto& point: curve) {
+        std::string memory;
+        for (int i = 1; i <= data.n_servers; i ++) {
+            int m = data.npus[i].size() > 1 ? CapacityPlanner::scaled_memory(data.npus[i][1].memory, point.memory_scale) : 0;
+            if (i > 1) memory += ",";
+            memory += std::to_string(m);
+        }
+        if (point.min_npus_per_server < 0) {
+            printf("%-14.2f %-28s %-20s %-24s %-12s %-8d (placed %d / %d users at max)\n", point.memory_scale, memory.c_str(),
+                ("> " + std::to_string(max_npus_per_server)).c_str(), "-", "-", point.probes, point.completed_users, data.m_users);
+        } else {
+            std::string by_server;
+            for (int i = 1; i <= data.n_servers; i ++) by_server += (i > 1 ? "," : "") + std::to_string(point.npus_by_server[i]);
+            printf("%-14.2f %-28s %-20d %-24s %-12d %-8d\n", point.memory_scale, memory.c_str(),
+                point.min_npus_per_server, by_server.c_str(), point.total_npus(), point.probes);
+        }
+    }
+    return 0;
+}
+
+
+// ===================================================================
+// Batchض
+// ===================================================================
+
+/*⣺ΪŷָʵļĿ¼ȡĿ¼.in
+ʵڹ̳߳в⣬ÿʵʱдԱߵ.outļ
+*/
+int run_batch(const std::string& spec, const TimeBudget& budget, int threads) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> inputs;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        fs::path p(item);
+        if (fs::is_directory(p)) {
+            std::vector<fs::path> found;
+            for (auto& entry: fs::recursive_directory_iterator(p)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".in") found.push_back(entry.path());
+            }
+            // validator--batchһ£ݹңͬһĿ¼ڰļе
+            std::sort(found.begin(), found.end(), [](const fs::path& x, const fs::path& y) {
+                if (x.parent_path() != y.parent_path()) return x.parent_path() < y.parent_path();
+                std::string sx = x.stem().string(), sy = y.stem().string();
+                bool dx = !sx.empty() && std::all_of(sx.begin(), sx.end(), ::isdigit);
+                bool dy = !sy.empty() && std::all_of(sy.begin(), sy.end(), ::isdigit);
+                if (dx && dy) return std::stoll(sx) < std::stoll(sy);
+                if (dx != dy) return dx;
+                return sx < sy;
+            });
+            inputs.insert(inputs.end(), found.begin(), found.end());
+        } else {
+            inputs.push_back(p);
+        }
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "No input files found in: %s\n", spec.c_str());
+        return 1;
+    }
+
+    struct Row {
+        std::string name;
+        int m_users = 0;
+        int completed = -1;
+        int upper_bound = -1;
+        double score = -1; // ȷ֣ûvalidator.hʱΪ-1
+        double seconds = 0;
+        bool ok = false;
+    };
+    std::vector<Row> rows(inputs.size());
+    auto batch_start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(std::max(1, std::min<int>(threads, inputs.size())));
+        std::vector<std::future<void> > futures;
+        for (size_t idx = 0; idx < inputs.size(); idx ++) {
+            futures.push_back(pool.submit([&, idx]() {
+                auto start = std::chrono::steady_clock::now();
+                Row& row = rows[idx];
+                row.name = inputs[idx].string();
+                ProblemData data;
+                if (!data.load_file(row.name)) return;
+                row.m_users = data.m_users;
+
+                TimeBudget instance_budget = budget.restarted(start);
+                CancellationToken token(instance_budget.deadline(TimeBudget::COMPACT));
+                SolverPortfolio portfolio = SolverPortfolio::make_default(false);
+                SolverPortfolio::Result best = portfolio.run(data, instance_budget, token);
+
+                fs::path out_path = inputs[idx];
+                out_path.replace_extension(".out");
+                std::string text;
+                {
+                    FastWriter out(&text);
+                    Solver::print_solution(best.best_solution, data.m_users, out);
+                }
+                std::ofstream file(out_path, std::ios::binary);
+                file.write(text.data(), text.size());
+                row.ok = (bool)file;
+                row.completed = best.max_completed_users;
+                row.upper_bound = RelaxationBoundModule().run(data).upper_bound;
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                row.seconds = elapsed.count();
+                if (ExactEvaluator::available()) {
+                    ExactEvaluator::Score score = ExactEvaluator::evaluate(data, best.best_solution);
+                    if (score.valid) row.score = score.final_score;
+                }
+            }));
+        }
+        for (auto& f: futures) f.get();
+    }
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - batch_start;
+
+    printf("%-50s %-10s %-22s %-14s %-16s %-12s\n", "Case", "Users", "Predicted Completed", "Upper Bound", "Exact Score", "Runtime (s)");
+    printf("%s\n", std::string(128, '-').c_str());
+    long long completed_sum = 0, bound_sum = 0, users_sum = 0;
+    double score_sum = 0;
+    int failed = 0;
+    for (auto& row: rows) {
+        if (!row.ok) {
+            printf("%-50s %-10s\n", row.name.c_str(), "FAILED");
+            failed ++;
+            continue;
+        }
+        std::string score = row.score < 0 ? "-" : std::to_string(row.score);
+        printf("%-50s %-10d %-22d %-14d %-16s %-12.2f\n", row.name.c_str(), row.m_users, row.completed, row.upper_bound, score.c_str(), row.seconds);
+        if (row.score > 0) score_sum += row.score;
+        completed_sum += row.completed;
+        bound_sum += row.upper_bound;
+        users_sum += row.m_users;
+    }
+    printf("%s\n", std::string(128, '-').c_str());
+    printf("Instances: %zu, failed: %d, predicted completed: %lld / %lld, upper bound: %lld, exact score: %.4f, wall time: %.2fs\n",
+        rows.size(), failed, completed_sum, users_sum, bound_sum, score_sum, total.count());
+    return failed == 0 ? 0 : 1;
+}
+
+
+// ===================================================================
+// START: Main Function
+// ===================================================================
+
+/* name=value вvalue*/
+const char* find_option(int argc, char* argv[], const char* name) {
+    size_t len = strlen(name);
+    for (int i = 1; i < argc; i ++) {
+        if (strncmp(argv[i], name, len) == 0) return argv[i] + len;
+    }
+    return nullptr;
+}
+
+bool has_flag(int argc, char* argv[], const char* name) {
+    for (int i = 1; i < argc; i ++) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
     auto program_start_time = std::chrono::steady_clock::now();
+    TimeBudget budget = TimeBudget::from_args(argc, argv, program_start_time);
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(NULL);
 
+    std::chrono::microseconds decision_budget(1000);
+    if (const char* v = find_option(argc, argv, "--decision-budget-us=")) decision_budget = std::chrono::microseconds(atoll(v));
+    if (has_flag(argc, argv, "--online")) {
+        return run_online(std::cin, decision_budget);
+    }
+    if (const char* batch_spec = find_option(argc, argv, "--batch=")) {
+        int threads = std::max(1u, std::thread::hardware_concurrency());
+        if (const char* v = find_option(argc, argv, "--threads=")) threads = std::max(1, atoi(v));
+        return run_batch(batch_spec, budget, threads);
+    }
+#ifndef _WIN32
+    if (has_flag(argc, argv, "--serve-stdio")) {
+        return run_daemon_stdio(budget, has_flag(argc, argv, "--exact-queue"));
+    }
+    if (const char* socket_path = find_option(argc, argv, "--serve=")) {
+        return run_daemon_socket(socket_path, budget, has_flag(argc, argv, "--exact-queue"));
+    }
+#endif
+
     LOG("start");
     ProblemData data;
-    data.read(std::cin);
+    if (const char* order = find_option(argc, argv, "--latency-order=")) {
+        if (strcmp(order, "server") == 0) data.latency_order = LatencyMatrix::SERVER_MAJOR;
+        else if (strcmp(order, "user") == 0) data.latency_order = LatencyMatrix::USER_MAJOR;
+        else {
+            fprintf(stderr, "Unknown latency order: %s (expected server or user)\n", order);
+            return 1;
+        }
+    }
+    const char* input_path = find_option(argc, argv, "--input=");
+    if (input_path != nullptr) {
+        if (!data.load_file(input_path)) {
+            fprintf(stderr, "Failed to load input: %s\n", input_path);
+            return 1;
+        }
+    } else {
+        data.read(std::cin);
+    }
+
+    const char* binary_path = find_option(argc, argv, "--convert-binary=");
+    if (binary_path != nullptr) {
+        if (!data.save_binary(binary_path)) {
+            fprintf(stderr, "Failed to write binary instance: %s\n", binary_path);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (has_flag(argc, argv, "--plan-capacity")) {
+        int threads = std::max(1u, std::thread::hardware_concurrency());
+        if (const char* v = find_option(argc, argv, "--threads=")) threads = std::max(1, atoi(v));
+        const char* scales = find_option(argc, argv, "--plan-memory=");
+        const char* max_npus = find_option(argc, argv, "--plan-max-npus=");
+        const char* probe_seconds = find_option(argc, argv, "--plan-probe-time=");
+        return run_capacity_plan(data, probe_seconds ? atof(probe_seconds) : 2.0, threads, scales ? scales : "0.5,0.75,1,1.5,2", max_npus ? atoi(max_npus) : 16);
+    }
+    if (has_flag(argc, argv, "--online-replay")) {
+        return run_online_replay(data, decision_budget);
+    }
 
     LOG("Data loaded. N_Servers: %d, M_Users: %d", data.n_servers, data.m_users);
     if (data.n_servers > 0 && data.npus[1].size() > 1) {
@@ -996,46 +2996,34 @@ int main() {
     }
     
 
-    std::vector<std::unique_ptr<Solver>> solvers;
-    solvers.push_back(std::make_unique<AutoTimeBlockSolver>());
-
-    
-    std::vector<std::vector<Schedule>> best_solution;
-    int max_completed_users = -1;
-    std::string best_solver_name = "None";
+    SolverPortfolio portfolio = SolverPortfolio::make_default(true, has_flag(argc, argv, "--exact-queue"));
 
     LOG("==============================================");
     LOG("Starting Solver Competition...");
     LOG("==============================================");
 
-    for (const auto& solver : solvers) {
-        LOG("--- Running Solver: %s ---", solver->name().c_str());
-        SolverResult result = solver->solve(data);
-        // **ע: ʹµı**
-        LOG("--- [Result] Solver: %s | Predicted Completed Users: %d ---", 
-            solver->name().c_str(), result.completed_user_count);
-
-        // **ע: ʹµı**
-        if (result.completed_user_count > max_completed_users) {
-            LOG("!!! New Best Solution Found! Previous best: %d users.", max_completed_users);
-            max_completed_users = result.completed_user_count;
-            best_solution = result.solution;
-            best_solver_name = solver->name();
-        }
-    }
+    CancellationToken token(budget.deadline(TimeBudget::COMPACT));
+    SolverPortfolio::Result best = portfolio.run(data, budget, token);
 
     LOG("==============================================");
     LOG("Competition Finished!");
-    LOG("Best Solver (by fast prediction): %s", best_solver_name.c_str());
-    // **ע: ʹµı**
-    LOG("Predicted Max Completed Users: %d", max_completed_users);
+    LOG("Best Solver (by fast prediction): %s", best.best_solver_name.c_str());
+    LOG("Predicted Max Completed Users: %d", best.max_completed_users);
     LOG("==============================================");
 
-    Solver::print_solution(best_solution, data.m_users);
+    Solver::print_solution(best.best_solution, data.m_users);
+    if (const char* path = find_option(argc, argv, "--predictions=")) {
+        if (!Solver::save_predictions(path, data, best.best_solution)) fprintf(stderr, "Failed to write predictions to %s\n", path);
+    }
 
     auto program_end_time = std::chrono::steady_clock::now();
     std::chrono::duration<double> elapsed_seconds = program_end_time - program_start_time;
     fprintf(stderr, "Total Execution Time: %.4f seconds\n", elapsed_seconds.count());
+    if (has_flag(argc, argv, "--report-bound")) {
+        RelaxationBoundModule::Result bound = RelaxationBoundModule().run(data);
+        fprintf(stderr, "Predicted Completed Users: %d, Upper Bound: %d, Gap: %d (infeasible alone: %d)\n",
+            best.max_completed_users, bound.upper_bound, bound.upper_bound - best.max_completed_users, bound.infeasible_alone);
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -51,11 +51,56 @@ class ScrollablePanel:
         screen.blit(content_surface, self.rect.topleft, (0, self.scroll_y, self.rect.width, self.rect.height))
         pygame.draw.rect(screen, GRAY, self.rect, 1, 5)
 
+LOG_COLUMNS = ['Time', 'NPU_Global_ID', 'Server_ID', 'NPU_Local_ID', 'Used_Memory', 'Max_Memory', 'Queue_Size',
+               'Running_Tasks_Count', 'Completed_Batch_Size_NPU', 'Cumulative_Batch_Size',
+               'Cumulative_Users_Completed_OnTime', 'Cumulative_Users_Timeout']
+# 二进制日志中按列存放的列，顺序与 validator.h 的 BinaryLogWriter 一致
+BINARY_COLUMNS = ['Time', 'NPU_Global_ID', 'Used_Memory', 'Queue_Size', 'Running_Tasks_Count', 'Completed_Batch_Size_NPU',
+                  'Cumulative_Batch_Size', 'Cumulative_Users_Completed_OnTime', 'Cumulative_Users_Timeout']
+
+def read_binary_log(filepath):
+    """读取评测器 --binary-log 输出的二进制日志，返回与文本日志列相同的DataFrame"""
+    with open(filepath, 'rb') as f:
+        data = f.read()
+    magic = b"NPULOG1\n"
+    if not data.startswith(magic):
+        raise ValueError("not a binary NPU log")
+    pos = len(magic)
+    def get():
+        nonlocal pos
+        value, shift = 0, 0
+        while True:
+            byte = data[pos]; pos += 1
+            value |= (byte & 0x7f) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+    npus = [(get(), get(), get()) for _ in range(get())]
+    columns = {name: [] for name in BINARY_COLUMNS}
+    while pos < len(data):
+        count = get()
+        if count == 0:
+            break
+        for name in BINARY_COLUMNS:
+            previous, column = 0, columns[name]
+            for _ in range(count):
+                zigzag = get()
+                previous += (zigzag >> 1) ^ -(zigzag & 1)
+                column.append(previous)
+    df = pd.DataFrame(columns)
+    df['Server_ID'] = [npus[g][0] for g in columns['NPU_Global_ID']]
+    df['NPU_Local_ID'] = [npus[g][1] for g in columns['NPU_Global_ID']]
+    df['Max_Memory'] = [npus[g][2] for g in columns['NPU_Global_ID']]
+    return df[LOG_COLUMNS]
+
 def load_data(filepath):
-    """加载、解析并预处理统一的日志文件"""
+    """加载、解析并预处理统一的日志文件，.bin 文件按二进制日志读取"""
     print(f"Loading data from '{filepath}'...")
     try:
-        df = pd.read_csv(filepath, sep=r'\s+', skiprows=[1], index_col=False)
+        if filepath.endswith('.bin'):
+            df = read_binary_log(filepath)
+        else:
+            df = pd.read_csv(filepath, sep=r'\s+', skiprows=[1], index_col=False)
         all_npu_ids = df['NPU_Global_ID'].unique()
         new_rows = []
         for npu_id in all_npu_ids:
@@ -163,7 +208,7 @@ def draw_bottom_panel(screen, scrubber_rect, font, current_time, max_time, butto
 
 def main():
     parser = argparse.ArgumentParser(description="Interactively visualizes NPU logs.", formatter_class=argparse.ArgumentDefaultsHelpFormatter)
-    parser.add_argument("--file", required=True, help="Path to the comprehensive simulation_log.txt file.")
+    parser.add_argument("--file", required=True, help="Path to the comprehensive simulation_log.txt file, or simulation_log.bin written with --binary-log.")
     parser.add_argument("--window", type=int, default=500, help="Initial width of the time window in ms.")
     args = parser.parse_args()
     
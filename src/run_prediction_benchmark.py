@@ -0,0 +1,207 @@
+import argparse
+import os
+import subprocess
+import sys
+import time
+import tempfile
+from pathlib import Path
+from multiprocessing import Pool
+
+# --- 1. 配置区域 ---
+CPP_SOURCE_FILE = "main.cpp"
+CPP_EXECUTABLE_NAME = "main.exe" if sys.platform == "win32" else "main"
+VALIDATOR_EXECUTABLE = "validator.exe" if sys.platform == "win32" else "validator"
+DEFAULT_BENCHMARKS = ["../benchmark1", "../benchmark2", "../benchmark3", "../benchmark4"]
+REPORT_FILE = Path("prediction_report.txt")
+
+# 完成时间误差（实际 - 预测）的直方图分桶，左闭右开
+ERROR_BUCKETS = [
+    ("<-100", float("-inf"), -100),
+    ("[-100,-1)", -100, -1),
+    ("-1", -1, 0),
+    ("0", 0, 1),
+    ("[1,10)", 1, 10),
+    ("[10,100)", 10, 100),
+    ("[100,1000)", 100, 1000),
+    (">=1000", 1000, float("inf")),
+]
+
+# --- 2. 核心函数 ---
+
+def compile_cpp(source, executable):
+    """编译 C++ 源代码"""
+    print(f"--- 正在编译 {source} -> {executable} ---")
+    try:
+        subprocess.run(
+            ["g++", source, "-o", executable, "-O2", "-std=c++17", "-pthread"],
+            check=True, capture_output=True, text=True
+        )
+        print("编译成功。")
+        return True
+    except FileNotFoundError:
+        print("错误: 未找到 g++ 编译器。请确保它已添加到系统的 PATH 中。")
+        return False
+    except subprocess.CalledProcessError as e:
+        print("错误: 编译失败。")
+        print(e.stderr)
+        return False
+
+def read_predictions(path):
+    """求解器 --predictions 输出：每行 user_id predicted_finish_time"""
+    predictions = {}
+    with open(path, 'r') as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) == 2:
+                predictions[int(parts[0])] = int(parts[1])
+    return predictions
+
+def read_users_log(path):
+    """评测器的 users_log.txt：返回 {user_id: (e, finish_time)}"""
+    actual = {}
+    with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) < 8 or not parts[0].isdigit():
+                continue
+            actual[int(parts[0])] = (int(parts[2]), int(parts[5]))
+    return actual
+
+def bucket_of(diff):
+    for name, lo, hi in ERROR_BUCKETS:
+        if lo <= diff < hi:
+            return name
+    return ERROR_BUCKETS[-1][0]
+
+def run_single_case(task):
+    """求解单个用例、调用评测器，并比较预测与实际的完成时间"""
+    input_path, solver, validator, time_limit = task
+    case_name = f"{input_path.parent.parent.name}/{input_path.parent.name}/{input_path.name}"
+    result = {'case': case_name, 'status': 'OK'}
+
+    # 评测器把日志写到当前目录，每个用例使用独立的临时目录以便并行
+    with tempfile.TemporaryDirectory() as work_dir:
+        work = Path(work_dir)
+        output_path = work / "solution.out"
+        prediction_path = work / "predictions.txt"
+        try:
+            with open(input_path, 'r') as f_in, open(output_path, 'w') as f_out:
+                subprocess.run(
+                    [solver, f"--time-limit={time_limit}", f"--predictions={prediction_path}"],
+                    stdin=f_in, stdout=f_out, stderr=subprocess.DEVNULL, check=True
+                )
+        except Exception as e:
+            result['status'] = f"Solver Error: {e}"
+            return result
+
+        validator_run = subprocess.run(
+            [validator, str(input_path), str(output_path)],
+            cwd=work, capture_output=True, text=True, encoding='utf-8', errors='ignore'
+        )
+        users_log = work / "users_log.txt"
+        if validator_run.returncode != 0 or not users_log.exists():
+            result['status'] = "Validator Failed"
+            return result
+
+        predictions = read_predictions(prediction_path)
+        actual = read_users_log(users_log)
+
+    histogram = {name: 0 for name, _, _ in ERROR_BUCKETS}
+    predicted_on_time = actual_on_time = lost = gained = exact = 0
+    for user_id, (e, finish) in actual.items():
+        predicted = predictions.get(user_id, -1)
+        pred_ok = 0 <= predicted <= e
+        real_ok = finish <= e
+        predicted_on_time += pred_ok
+        actual_on_time += real_ok
+        lost += pred_ok and not real_ok     # 预测准时但实际超时
+        gained += real_ok and not pred_ok   # 预测超时但实际准时
+        exact += finish == predicted
+        histogram[bucket_of(finish - predicted)] += 1
+
+    result.update({
+        'users': len(actual),
+        'predicted_on_time': predicted_on_time,
+        'actual_on_time': actual_on_time,
+        'lost': lost,
+        'gained': gained,
+        'exact': exact,
+        'histogram': histogram,
+    })
+    return result
+
+def generate_report(results):
+    """控制台与报告文件各输出一份：每个用例的准时人数差异和完成时间误差直方图"""
+    bucket_names = [name for name, _, _ in ERROR_BUCKETS]
+    header = (f"{'Case':<32} {'Users':<7} {'Pred OnTime':<12} {'Real OnTime':<12} "
+              f"{'Lost':<6} {'Gained':<7} {'Exact':<7} " + " ".join(f"{n:<11}" for n in bucket_names))
+    lines = ["--- Prediction Accuracy Report ---", "finish error = actual - predicted", "", header, "-" * len(header)]
+    totals = {'users': 0, 'predicted_on_time': 0, 'actual_on_time': 0, 'lost': 0, 'gained': 0, 'exact': 0}
+    total_histogram = {name: 0 for name in bucket_names}
+    for res in results:
+        if res['status'] != 'OK':
+            lines.append(f"{res['case']:<32} {res['status']}")
+            continue
+        for key in totals:
+            totals[key] += res[key]
+        for name in bucket_names:
+            total_histogram[name] += res['histogram'][name]
+        lines.append(
+            f"{res['case']:<32} {res['users']:<7} {res['predicted_on_time']:<12} {res['actual_on_time']:<12} "
+            f"{res['lost']:<6} {res['gained']:<7} {res['exact']:<7} "
+            + " ".join(f"{res['histogram'][n]:<11}" for n in bucket_names)
+        )
+    lines.append("-" * len(header))
+    lines.append(
+        f"{'TOTAL':<32} {totals['users']:<7} {totals['predicted_on_time']:<12} {totals['actual_on_time']:<12} "
+        f"{totals['lost']:<6} {totals['gained']:<7} {totals['exact']:<7} "
+        + " ".join(f"{total_histogram[n]:<11}" for n in bucket_names)
+    )
+    text = "\n".join(lines) + "\n"
+    print(text)
+    with open(REPORT_FILE, 'w', encoding='utf-8') as f:
+        f.write(text)
+    print(f"报告已保存到 {REPORT_FILE}")
+    return totals
+
+# --- 3. 主逻辑 ---
+def main(args):
+    if not args.no_compile and not compile_cpp(CPP_SOURCE_FILE, CPP_EXECUTABLE_NAME):
+        sys.exit(1)
+    solver = str(Path(args.solver).resolve())
+    validator = str(Path(args.validator).resolve())
+    if not Path(validator).exists():
+        print(f"错误: 验证器未找到 '{args.validator}'")
+        sys.exit(1)
+
+    input_files = []
+    for root in args.benchmarks:
+        input_files.extend(sorted(
+            Path(root).rglob('*.in'),
+            key=lambda p: (str(p.parent), int(p.stem) if p.stem.isdigit() else float('inf'))
+        ))
+    if not input_files:
+        print("警告: 未找到任何 '.in' 文件。")
+        return
+    print(f"共找到 {len(input_files)} 个测试用例。")
+
+    start_time = time.time()
+    tasks = [(p.resolve(), solver, validator, args.time_limit) for p in input_files]
+    with Pool(processes=max(1, args.workers)) as pool:
+        results = pool.map(run_single_case, tasks)
+    totals = generate_report(results)
+    print(f"总耗时 {time.time() - start_time:.2f}s")
+    # 有预测准时但实际超时的用户时返回非零，便于在回归中发现模拟器退化
+    if args.strict and totals['lost'] > 0:
+        sys.exit(2)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="比较求解器预测的完成时间与评测器实际的完成时间。")
+    parser.add_argument("benchmarks", nargs="*", default=DEFAULT_BENCHMARKS, help="包含 .in 文件的目录，默认 benchmark1~4")
+    parser.add_argument("--time-limit", type=float, default=28, help="传给求解器的时间预算（秒）")
+    parser.add_argument("--solver", default=f"./{CPP_EXECUTABLE_NAME}", help="求解器可执行文件")
+    parser.add_argument("--validator", default=f"./{VALIDATOR_EXECUTABLE}", help="评测器可执行文件")
+    parser.add_argument("--no-compile", action="store_true", help="跳过编译，直接使用已有的求解器")
+    parser.add_argument("-w", "--workers", type=int, default=os.cpu_count() or 1, help="并行进程数")
+    parser.add_argument("--strict", action="store_true", help="存在预测准时但实际超时的用户时以非零状态退出")
+    main(parser.parse_args())
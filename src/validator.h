@@ -0,0 +1,1520 @@
+// validator.h
+// ֵ֤ĺģvalidator.cpp main.cppá
+// ȿԴ/ļҲڴӷû󣬲κļд
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <set>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <thread>
+#include <atomic>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace validator {
+
+// --- ݽṹ ---
+struct LogEntry {
+    long long time;
+    int npu_global_id, server_id, npu_local_id, used_memory, max_memory;
+    int queue_size, running_tasks_count, completed_batch_size_npu;
+    long long cumulative_batch_size;
+    int cumulative_users_completed_on_time, cumulative_users_timeout;
+};
+
+// ޸1ûͳ־Ľṹ
+struct UserLogEntry {
+    int user_id;
+    long long s, e;
+    int cnt;
+    int request_count;
+    long long finish_time;
+    long long time_diff; // finish_time - e
+    double avg_batch_size;
+};
+
+
+// ݽṹޱ仯
+struct Request {
+    int user_id, server_id, npu_id, batch_size;
+    long long send_time, arrival_time;
+};
+// NPUϵȴ׼󣬰(ʱ, ûid)С
+// ¼֤˳򵽴ֻ׷ӣ߶άλڴСֵ
+// ׼ʱֱһŵµ󣬶С󶼷Ųʱֹͣ
+class AdmissionQueue {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    void push(const Request& request, int memory_needed) {
+        if (pending == 0) { requests.clear(); memory.clear(); }
+        requests.push_back(request);
+        memory.push_back(memory_needed);
+        if (requests.size() > capacity) rebuild();
+        else update(requests.size() - 1);
+        pending++;
+    }
+    // from ֮һڴ治 limit λãû򷵻 npos
+    size_t find_first(size_t from, int limit) const {
+        if (from >= requests.size() || tree[1] > limit) return npos;
+        return find_first(1, 0, capacity, from, limit);
+    }
+    void take(size_t pos) { memory[pos] = INF; update(pos); pending--; }
+    const Request& request(size_t pos) const { return requests[pos]; }
+    int memory_needed(size_t pos) const { return memory[pos]; }
+    size_t size() const { return pending; }
+
+private:
+    static constexpr int INF = std::numeric_limits<int>::max();
+    std::vector<Request> requests;
+    std::vector<int> memory; // ׼λΪINF
+    std::vector<int> tree = std::vector<int>(2, INF);
+    size_t capacity = 1, pending = 0;
+
+    void rebuild() {
+        while (capacity < requests.size()) capacity *= 2;
+        tree.assign(2 * capacity, INF);
+        std::copy(memory.begin(), memory.end(), tree.begin() + capacity);
+        for (size_t i = capacity - 1; i >= 1; --i) tree[i] = std::min(tree[2 * i], tree[2 * i + 1]);
+    }
+    void update(size_t pos) {
+        size_t i = capacity + pos;
+        tree[i] = memory[pos];
+        for (i /= 2; i >= 1; i /= 2) tree[i] = std::min(tree[2 * i], tree[2 * i + 1]);
+    }
+    size_t find_first(size_t node, size_t lo, size_t hi, size_t from, int limit) const {
+        if (hi <= from || tree[node] > limit) return npos;
+        if (hi - lo == 1) return lo;
+        size_t mid = (lo + hi) / 2;
+        size_t pos = find_first(2 * node, lo, mid, from, limit);
+        return pos != npos ? pos : find_first(2 * node + 1, mid, hi, from, limit);
+    }
+};
+
+struct NPU {
+    int server_id, local_id, memory_limit, used_memory = 0;
+    AdmissionQueue queue;
+    struct RunningTask {
+        Request request; long long finish_time; int memory_used;
+        bool operator>(const RunningTask& other) const { return finish_time > other.finish_time; }
+    };
+    std::vector<RunningTask> running_tasks; // finish_timeС
+    int stalled_tasks = 0; // ʱ䲻ΪbatchΪԶɣֻռڴ沢
+    int running_count() const { return static_cast<int>(running_tasks.size()) + stalled_tasks; }
+};
+struct Server {
+    int id, npu_count, k, memory;
+    std::vector<int> npu_global_ids;
+};
+struct User {
+    int id, cnt_required, cnt_processed = 0, last_npu_global_id = -1, migrations = 0;
+    int a, b;
+    long long s, e, finish_time = -1, next_allowed_send_time;
+    bool has_finished = false;
+    std::vector<Request> requests;
+};
+
+// ֻ
+struct ScoreSummary {
+    size_t total_users = 0;
+    int late_users = 0;
+    double k_penalty = 0;
+    double total_score = 0;
+    double final_score = 0;
+};
+
+// ֤ʧʱ׳ڸӡطֵ
+class ValidationError: public std::runtime_error {
+public:
+    ValidationError(const std::string& error_type, const std::string& details)
+        : std::runtime_error(error_type + ": " + details), error_type(error_type), details(details) {}
+    std::string error_type, details;
+};
+
+// --- ļȡ ---
+// ֻӳļ֧mmapʱ˻Ϊ
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return; }
+        length = st.st_size;
+        if (length > 0) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) { base = static_cast<const char*>(p); mapped = true; }
+        }
+        ::close(fd);
+        ok = length == 0 || mapped;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return;
+        owned.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        base = owned.data(); length = owned.size();
+        ok = true;
+#endif
+    }
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(base), length);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return ok; }
+    const char* begin() const { return base; }
+    const char* end() const { return base + length; }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+    bool ok = false, mapped = false;
+    std::vector<char> owned;
+};
+
+// ڴеıϵɨ istream >> ͬհףѡţһλ֣ΧΪʧܡ
+// нʱβ'\n'read_in_line Խ
+class OutputScanner {
+public:
+    OutputScanner(const char* begin, const char* end): p(begin), end(end) {}
+
+    // ڵĿհ׺һӦ file >> value
+    template <typename Int>
+    bool read(Int& value) {
+        while (p < end && is_space(*p)) ++p;
+        return read_number(value);
+    }
+    // ֻڵǰհףӦ getline õ ss >> value
+    template <typename Int>
+    bool read_in_line(Int& value) {
+        while (p < end && *p != '\n' && is_space(*p)) ++p;
+        if (p < end && *p == '\n') return false;
+        return read_number(value);
+    }
+    // ǰʣಿ֣Ӧ getline 
+    void skip_line() {
+        while (p < end && *p != '\n') ++p;
+        if (p < end) ++p;
+    }
+    // ǰʣಿֲһУһвڣѵļĩβʱfalseӦ getline Ľ
+    bool next_line() {
+        while (p < end && *p != '\n') ++p;
+        if (p == end) return false;
+        ++p;
+        return p < end;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    static bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+    template <typename Int>
+    bool read_number(Int& value) {
+        const char* q = p;
+        bool negative = false;
+        if (q < end && (*q == '+' || *q == '-')) negative = *q++ == '-';
+        if (q == end || *q < '0' || *q > '9') return false;
+        // ֵۼӣ Int ķΧʱʧ
+        unsigned long long limit = negative ? static_cast<unsigned long long>(std::numeric_limits<Int>::max()) + 1
+                                            : static_cast<unsigned long long>(std::numeric_limits<Int>::max());
+        unsigned long long magnitude = 0;
+        bool overflow = false;
+        for (; q < end && *q >= '0' && *q <= '9'; ++q) {
+            if (magnitude > (limit - (*q - '0')) / 10) overflow = true;
+            else magnitude = magnitude * 10 + (*q - '0');
+        }
+        p = q;
+        if (overflow) return false;
+        value = negative ? static_cast<Int>(-static_cast<long long>(magnitude - 1) - 1) : static_cast<Int>(magnitude);
+        return true;
+    }
+};
+
+// --- NPU־ ---
+// ı־ıͷÿиʽsave_log_file Ͷ־ת
+inline void write_log_header(std::ostream& file) {
+    file << std::left
+         << std::setw(10) << "Time"
+         << std::setw(15) << "NPU_Global_ID"
+         << std::setw(12) << "Server_ID"
+         << std::setw(14) << "NPU_Local_ID"
+         << std::setw(15) << "Used_Memory"
+         << std::setw(12) << "Max_Memory"
+         << std::setw(12) << "Queue_Size"
+         << std::setw(22) << "Running_Tasks_Count"
+         << std::setw(28) << "Completed_Batch_Size_NPU"
+         << std::setw(28) << "Cumulative_Batch_Size"
+         << std::setw(35) << "Cumulative_Users_Completed_OnTime"
+         << "Cumulative_Users_Timeout" << "\n";
+    file << std::string(200, '-') << "\n";
+}
+
+inline void write_log_row(std::ostream& file, const LogEntry& entry) {
+    file << std::left
+         << std::setw(10) << entry.time
+         << std::setw(15) << entry.npu_global_id
+         << std::setw(12) << entry.server_id
+         << std::setw(14) << entry.npu_local_id
+         << std::setw(15) << entry.used_memory
+         << std::setw(12) << entry.max_memory
+         << std::setw(12) << entry.queue_size
+         << std::setw(22) << entry.running_tasks_count
+         << std::setw(28) << entry.completed_batch_size_npu
+         << std::setw(28) << entry.cumulative_batch_size
+         << std::setw(35) << entry.cumulative_users_completed_on_time
+         << entry.cumulative_users_timeout << "\n";
+}
+
+// ־ģббдڴֻһ顣ļʽ
+//   ħ "NPULOG1\n"NPUԼÿNPUķididڴޣ
+//   ɿ飬ÿΪϰдŵݣÿд뱾һеĲֵzigzag + varint֮以
+//   Ϊ0ĿʾididڴNPUȫidд洢
+class BinaryLogWriter {
+public:
+    static constexpr size_t BLOCK_ROWS = 4096;
+
+    bool open(const std::string& path, const std::vector<NPU>& npus) {
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        file.write(MAGIC, sizeof(MAGIC) - 1);
+        put(npus.size());
+        for (const auto& npu : npus) {
+            put(npu.server_id); put(npu.local_id); put(npu.memory_limit);
+        }
+        flush_bytes();
+        rows.reserve(BLOCK_ROWS);
+        return true;
+    }
+    bool is_open() const { return file.is_open(); }
+    void append(const LogEntry& entry) {
+        rows.push_back(entry);
+        if (rows.size() == BLOCK_ROWS) flush_block();
+    }
+    void close() {
+        if (!file.is_open()) return;
+        flush_block();
+        put(0);
+        flush_bytes();
+        file.close();
+    }
+    ~BinaryLogWriter() { close(); }
+
+    static constexpr char MAGIC[] = "NPULOG1\n";
+
+private:
+    std::ofstream file;
+    std::vector<LogEntry> rows;
+    std::string bytes;
+
+    void put(unsigned long long value) {
+        while (value >= 0x80) { bytes.push_back(static_cast<char>(value | 0x80)); value >>= 7; }
+        bytes.push_back(static_cast<char>(value));
+    }
+    template <typename Field>
+    void put_column(Field field) {
+        long long previous = 0;
+        for (const auto& row : rows) {
+            long long delta = static_cast<long long>(field(row)) - previous;
+            previous = field(row);
+            put((static_cast<unsigned long long>(delta) << 1) ^ static_cast<unsigned long long>(delta >> 63));
+        }
+    }
+    void flush_block() {
+        if (rows.empty()) return;
+        put(rows.size());
+        put_column([](const LogEntry& r) { return r.time; });
+        put_column([](const LogEntry& r) { return r.npu_global_id; });
+        put_column([](const LogEntry& r) { return r.used_memory; });
+        put_column([](const LogEntry& r) { return r.queue_size; });
+        put_column([](const LogEntry& r) { return r.running_tasks_count; });
+        put_column([](const LogEntry& r) { return r.completed_batch_size_npu; });
+        put_column([](const LogEntry& r) { return r.cumulative_batch_size; });
+        put_column([](const LogEntry& r) { return r.cumulative_users_completed_on_time; });
+        put_column([](const LogEntry& r) { return r.cumulative_users_timeout; });
+        rows.clear();
+        flush_bytes();
+    }
+    void flush_bytes() { file.write(bytes.data(), bytes.size()); bytes.clear(); }
+};
+
+// жضNPU־ͬһֻһ
+class BinaryLogReader {
+public:
+    explicit BinaryLogReader(const std::string& path): file(path, std::ios::binary) {
+        char magic[sizeof(BinaryLogWriter::MAGIC) - 1];
+        if (!file.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != BinaryLogWriter::MAGIC) {
+            throw ValidationError("Log File Error", "Not a binary NPU log: " + path);
+        }
+        npus.resize(get());
+        for (auto& npu : npus) {
+            npu.server_id = get(); npu.local_id = get(); npu.memory_limit = get();
+        }
+    }
+    bool next(LogEntry& entry) {
+        if (cursor == rows.size() && !read_block()) return false;
+        entry = rows[cursor++];
+        const NPU& npu = npus.at(entry.npu_global_id);
+        entry.server_id = npu.server_id; entry.npu_local_id = npu.local_id; entry.max_memory = npu.memory_limit;
+        return true;
+    }
+
+private:
+    std::ifstream file;
+    std::vector<NPU> npus;
+    std::vector<LogEntry> rows;
+    size_t cursor = 0;
+
+    unsigned long long get() {
+        unsigned long long value = 0;
+        for (int shift = 0; ; shift += 7) {
+            int byte = file.get();
+            if (byte == EOF) throw ValidationError("Log File Error", "Truncated binary NPU log.");
+            value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+    }
+    template <typename Field>
+    void get_column(Field field) {
+        long long previous = 0;
+        for (auto& row : rows) {
+            unsigned long long zigzag = get();
+            previous += static_cast<long long>(zigzag >> 1) ^ -static_cast<long long>(zigzag & 1);
+            field(row) = previous;
+        }
+    }
+    bool read_block() {
+        // ģ;ʧʱļûн飬ļĩβͬΪ
+        if (file.peek() == EOF) return false;
+        size_t count = get();
+        if (count == 0) return false;
+        rows.assign(count, LogEntry{});
+        cursor = 0;
+        get_column([](LogEntry& r) -> long long& { return r.time; });
+        get_column([](LogEntry& r) -> int& { return r.npu_global_id; });
+        get_column([](LogEntry& r) -> int& { return r.used_memory; });
+        get_column([](LogEntry& r) -> int& { return r.queue_size; });
+        get_column([](LogEntry& r) -> int& { return r.running_tasks_count; });
+        get_column([](LogEntry& r) -> int& { return r.completed_batch_size_npu; });
+        get_column([](LogEntry& r) -> long long& { return r.cumulative_batch_size; });
+        get_column([](LogEntry& r) -> int& { return r.cumulative_users_completed_on_time; });
+        get_column([](LogEntry& r) -> int& { return r.cumulative_users_timeout; });
+        return true;
+    }
+};
+
+// --- ־ ---
+// Ϊ compute_score / calculate_score ڵģÿ׹ڱչɸԵѭ
+// û÷Ϊ h * p * q * 10000ܷٳԳٵͷ h(K)
+struct StandardScoring {
+    // ûδʱΪfalseʱ unfinished_finish_time ɼƷ֣Ҳٵ
+    static constexpr bool require_finished = true;
+    static constexpr long long unfinished_finish_time = -1;
+    static double user_weight(int user_id) { return std::pow(2.0, -static_cast<double>(user_id) / 5000.0); }
+    static double migration_penalty(int migrations) { return std::pow(2.0, -static_cast<double>(migrations) / 200.0); }
+    static double late_penalty(int late_users) { return std::pow(2.0, -static_cast<double>(late_users) / 100.0); }
+};
+
+// new_vali.cpp Ĺδɵû999999ɼƷ
+struct LenientScoring: StandardScoring {
+    static constexpr bool require_finished = false;
+    static constexpr long long unfinished_finish_time = 999999;
+};
+
+// дЩ־
+struct FullLogging {
+    static constexpr bool npu_log = true;
+    static constexpr bool users_log = true;
+};
+
+// new_vali.cpp ֻдNPU־
+struct NpuLogOnly {
+    static constexpr bool npu_log = true;
+    static constexpr bool users_log = false;
+};
+
+// --- ģ ---
+class Simulator {
+public:
+    // ÷ļ벢ӡ
+    Simulator(const std::string& input_path, const std::string& output_path);
+    // ڴ÷Ĭϲӡ¼NPU־ε add_server / add_user / set_latency
+    // ٶÿû begin_user_requests / add_request / end_user_requests
+    Simulator(): verbose(false), record_log(false) {}
+
+    // ڴ÷ֱӴ/ļ룬ӡ
+    void load(const std::string& input_path, const std::string& output_path);
+
+    void set_output(bool verbose, bool record_log) { this->verbose = verbose; this->record_log = record_log; }
+    // run ʹõ߳1ʱNPUƬģ⣨ run_sharded־͵߳ȫͬ
+    void set_threads(int threads) { simulation_threads = std::max(1, threads); }
+    // ģʱNPU־ʽдļʽ BinaryLogWriter record_log ໥з֮
+    void set_binary_log(const std::string& filepath);
+
+    void add_server(int npu_count, int k, int memory);
+    void add_user(long long s, long long e, int cnt, int a, int b);
+    void set_latency(int user_id, int server_id, int latency);
+    void begin_user_requests(int user_id, int t_i);
+    void add_request(int user_id, long long send_time, int server_id, int npu_id, int batch_size);
+    void end_user_requests(int user_id);
+
+    void run();
+    template <class Scoring = StandardScoring> ScoreSummary compute_score() const;
+    template <class Scoring = StandardScoring> void calculate_score();
+    void save_log_file(const std::string& filepath = "simulation_log.txt");
+    void save_users_log(const std::string& filepath = "users_log.txt"); // 
+
+private:
+    template <class> friend class IncrementalScorer;
+
+    bool verbose = true;
+    bool record_log = true;
+    int simulation_threads = 1;
+    std::vector<Server> servers;
+    std::vector<User> users; // ±Ϊ user_id - 1
+    std::vector<NPU> npus;   // ±ΪNPUȫid
+    std::vector<int> latencies; // ʱӾ󣬰 (user_id - 1) *  + (server_id - 1) ţδΪ-1
+
+    long long total_samples_to_process = 0;
+    std::vector<LogEntry> log_data;
+    BinaryLogWriter binary_log;
+
+    long long cumulative_batch_size_processed = 0;
+    int cumulative_users_completed_on_time = 0;
+    int cumulative_users_timeout = 0;
+
+    enum class EventType { SEND, ARRIVE };
+    // 뵽ʱڽȷ¼һ԰ʱźģʱ˳ƽ
+    struct Event {
+        long long time;
+        EventType type;
+        const Request* payload;
+    };
+    std::vector<Event> events;
+    size_t next_event = 0;
+    // NPU(ʱ, NPUȫid)ÿһҳһʱԼʱɵNPU
+    std::priority_queue<std::pair<long long, int>, std::vector<std::pair<long long, int>>, std::greater<std::pair<long long, int>>> completions;
+    bool events_populated = false;
+    void parse_input(const std::string& path);
+    void parse_output(const std::string& path);
+    void populate_initial_events();
+    long long run_sequential();
+    long long run_sharded();
+    // NPUģĽÿɻ󵽴ʱһУcompleted δŸʱɵ(ûid, batch)
+    struct NpuTrace {
+        struct Tick {
+            long long time;
+            int used_memory, queue_size, running_count, completed_batch;
+            size_t completed_end; // ʱɵΪ completed[һе completed_end, completed_end)
+        };
+        std::vector<Tick> ticks;
+        std::vector<std::pair<int, int>> completed;
+    };
+    void simulate_npu(int gid, const std::vector<const Request*>& arrivals, NpuTrace& trace);
+    void finish_task(int user_id, int batch_size, long long current_time, long long& processed_samples);
+    void write_log_entry(const LogEntry& entry);
+    void report_progress(long long processed_samples, long long current_time, int& last_percent) const;
+    static void check_request_count(int user_id, int t_i);
+    Request make_request(const User& user, const std::vector<Request>& previous, long long send_time, int server_id, int npu_id, int batch_size) const;
+    static void check_total_samples(const User& user, const std::vector<Request>& requests);
+    static long long processing_time(int k, int batch_size) {
+        double inference_speed = (batch_size > 0) ? k * std::sqrt(batch_size) : 1.0;
+        return (inference_speed > 0) ? static_cast<long long>(std::ceil(batch_size / inference_speed)) : 0;
+    }
+    template <class Scoring>
+    static double user_score(const User& user, long long finish_time, int migrations) {
+        double h_arg = 0;
+        if (user.e > user.s) h_arg = static_cast<double>(finish_time - user.e) / (user.e - user.s);
+        else if (finish_time > user.e) h_arg = std::numeric_limits<double>::infinity();
+        double h_val = std::pow(2.0, -h_arg / 100.0);
+        double p_val = Scoring::migration_penalty(migrations);
+        double q_val = Scoring::user_weight(user.id);
+        return h_val * p_val * q_val * 10000.0;
+    }
+    [[noreturn]] static void fail_with_error(const std::string& error_type, const std::string& message);
+};
+
+// --- Simulator෽ʵ ---
+inline Simulator::Simulator(const std::string& input_path, const std::string& output_path) {
+    std::cout << "--- 1. Parsing Input File ---" << std::endl;
+    parse_input(input_path);
+    std::cout << "Input parsing complete." << std::endl;
+    std::cout << "--- 2. Parsing Output File ---" << std::endl;
+    parse_output(output_path);
+    std::cout << "Output parsing and validation complete." << std::endl;
+    populate_initial_events();
+}
+
+inline void Simulator::load(const std::string& input_path, const std::string& output_path) {
+    parse_input(input_path);
+    parse_output(output_path);
+    populate_initial_events();
+}
+
+inline void Simulator::fail_with_error(const std::string& error_type, const std::string& message) {
+    throw ValidationError(error_type, message);
+}
+
+inline void Simulator::add_server(int npu_count, int k, int memory) {
+    Server s; s.id = servers.size() + 1;
+    s.npu_count = npu_count; s.k = k; s.memory = memory;
+    for (int j = 0; j < s.npu_count; ++j) {
+        s.npu_global_ids.push_back(npus.size());
+        npus.push_back(NPU{s.id, j + 1, s.memory});
+    }
+    servers.push_back(s);
+}
+
+inline void Simulator::add_user(long long s, long long e, int cnt, int a, int b) {
+    User u; u.id = users.size() + 1;
+    u.s = s; u.e = e; u.cnt_required = cnt; u.a = a; u.b = b;
+    u.next_allowed_send_time = u.s;
+    users.push_back(u);
+    total_samples_to_process += u.cnt_required;
+}
+
+inline void Simulator::set_binary_log(const std::string& filepath) {
+    if (!binary_log.open(filepath, npus)) fail_with_error("Log File Error", "Could not open file: " + filepath);
+}
+
+// ʱӾ󰴵ǰûͷŲҪз֮
+inline void Simulator::set_latency(int user_id, int server_id, int latency) {
+    if (user_id < 1 || (size_t)user_id > users.size()) throw std::out_of_range("set_latency: user_id " + std::to_string(user_id));
+    if (server_id < 1 || (size_t)server_id > servers.size()) throw std::out_of_range("set_latency: server_id " + std::to_string(server_id));
+    if (latencies.size() < users.size() * servers.size()) latencies.resize(users.size() * servers.size(), -1);
+    latencies[(user_id - 1) * servers.size() + (server_id - 1)] = latency;
+}
+
+inline void Simulator::parse_input(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) fail_with_error("Input File Error", "Could not open file: " + path);
+    int n_servers; file >> n_servers;
+    for (int i = 0; i < n_servers; ++i) {
+        int npu_count, k, memory;
+        file >> npu_count >> k >> memory;
+        add_server(npu_count, k, memory);
+    }
+    int m_users; file >> m_users;
+    for (int i = 0; i < m_users; ++i) {
+        long long s, e; int cnt;
+        file >> s >> e >> cnt;
+        add_user(s, e, cnt, 0, 0);
+    }
+    for (int i = 0; i < n_servers; ++i) {
+        for (int j = 0; j < m_users; ++j) {
+            int lat; file >> lat;
+            set_latency(j + 1, i + 1, lat);
+        }
+    }
+    for (int i = 0; i < m_users; ++i) {
+        file >> users[i].a >> users[i].b;
+    }
+}
+
+inline void Simulator::check_request_count(int user_id, int t_i) {
+    if (t_i < 1 || t_i > 300) fail_with_error("Invalid Output Constraint", "User " + std::to_string(user_id) + ": T_i=" + std::to_string(t_i) + " is not in range [1, 300].");
+}
+
+inline void Simulator::begin_user_requests(int user_id, int t_i) {
+    check_request_count(user_id, t_i);
+    users.at(user_id - 1).requests.reserve(t_i);
+}
+
+// ̬飺ͼʱޡ/NPU±ꡢbatchռڴ棻previous Ϊûǰ
+inline Request Simulator::make_request(const User& user, const std::vector<Request>& previous, long long send_time, int server_id, int npu_id, int batch_size) const {
+    int user_id = user.id;
+    int j = previous.size();
+    long long temp_next_allowed_send_time = previous.empty() ? user.s : previous.back().arrival_time + 1;
+    Request req; req.user_id = user_id;
+    req.send_time = send_time; req.server_id = server_id; req.npu_id = npu_id; req.batch_size = batch_size;
+    if (req.send_time < temp_next_allowed_send_time) fail_with_error("Invalid User Send Time (Static Check)", "User " + std::to_string(user_id) + " req " + std::to_string(j+1) + ": time " + std::to_string(req.send_time) + " < " + std::to_string(temp_next_allowed_send_time) + ".");
+    if (req.send_time > 1000000) fail_with_error("Invalid User Send Time", "User " + std::to_string(user_id) + " req " + std::to_string(j + 1) + ": time " + std::to_string(req.send_time) + " > 1,000,000.");
+    if (req.server_id < 1 || (size_t)req.server_id > servers.size()) fail_with_error("Invalid Server Index", "User " + std::to_string(user_id) + " req " + std::to_string(j + 1) + ": server index " + std::to_string(req.server_id) + " out of bounds.");
+    const Server& server = servers[req.server_id - 1];
+    if (req.npu_id < 1 || req.npu_id > server.npu_count) fail_with_error("Invalid NPU Index", "User " + std::to_string(user_id) + " req " + std::to_string(j + 1) + ": NPU index " + std::to_string(req.npu_id) + " out of bounds for server " + std::to_string(req.server_id));
+    if (user.a * req.batch_size + user.b > server.memory) fail_with_error("Batchsize Exceeds Memory", "User " + std::to_string(user_id) + " req " + std::to_string(j + 1) + ": batch size " + std::to_string(req.batch_size) + " exceeds server " + std::to_string(req.server_id) + "'s memory.");
+    size_t latency_index = (user_id - 1) * servers.size() + (req.server_id - 1);
+    if (latency_index >= latencies.size() || latencies[latency_index] < 0) fail_with_error("Missing Latency", "User " + std::to_string(user_id) + " server " + std::to_string(req.server_id) + ": latency not set.");
+    req.arrival_time = req.send_time + latencies[latency_index];
+    return req;
+}
+
+inline void Simulator::add_request(int user_id, long long send_time, int server_id, int npu_id, int batch_size) {
+    User& user = users.at(user_id - 1);
+    user.requests.push_back(make_request(user, user.requests, send_time, server_id, npu_id, batch_size));
+}
+
+inline void Simulator::check_total_samples(const User& user, const std::vector<Request>& requests) {
+    int user_id = user.id;
+    long long user_total_samples = 0;
+    for (const auto& req : requests) user_total_samples += req.batch_size;
+    if (user_total_samples != user.cnt_required) fail_with_error("Samples Not Fully Processed", "User " + std::to_string(user_id) + ": Total batch sizes sum to " + std::to_string(user_total_samples) + ", but " + std::to_string(user.cnt_required) + " were required.");
+}
+
+inline void Simulator::end_user_requests(int user_id) {
+    const User& user = users.at(user_id - 1);
+    check_total_samples(user, user.requests);
+}
+
+// ÿûУT_i еݺԣһж T_i ڶҲ
+inline void Simulator::parse_output(const std::string& path) {
+    MappedFile file(path);
+    if (!file.is_open()) fail_with_error("Output File Error", "Could not open file: " + path);
+    OutputScanner scanner(file.begin(), file.end());
+    for (size_t i = 0; i < users.size(); ++i) {
+        int user_id = i + 1;
+        int t_i;
+        if (!scanner.read(t_i)) fail_with_error("Output File Format", "Could not read T_i for user " + std::to_string(user_id));
+        begin_user_requests(user_id, t_i);
+        if (!scanner.next_line()) fail_with_error("Output File Format", "Missing request line for user " + std::to_string(user_id));
+        for (int j = 0; j < t_i; ++j) {
+            long long send_time; int server_id, npu_id, batch_size;
+            if (!(scanner.read_in_line(send_time) && scanner.read_in_line(server_id) && scanner.read_in_line(npu_id) && scanner.read_in_line(batch_size))) fail_with_error("Output File Format", "User " + std::to_string(user_id) + ": Not enough integers for request " + std::to_string(j+1));
+            add_request(user_id, send_time, server_id, npu_id, batch_size);
+        }
+        scanner.skip_line();
+        end_user_requests(user_id);
+    }
+}
+
+// ͬһʱȴٴﰴʱԭͺ׷ӵ¼˳ͬ
+inline void Simulator::populate_initial_events() {
+    events.clear();
+    for(const User& user : users) {
+        for(const auto& req : user.requests) {
+            events.push_back({req.send_time, EventType::SEND, &req});
+        }
+    }
+    size_t send_count = events.size();
+    for (size_t i = 0; i < send_count; ++i) {
+        events.push_back({events[i].payload->arrival_time, EventType::ARRIVE, events[i].payload});
+    }
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.time != b.time) return a.time < b.time;
+        if (a.type != b.type) return a.type == EventType::SEND;
+        // ͬʱİûidʹÿNPUĵȴֻ׷
+        return a.type == EventType::ARRIVE && a.payload->user_id < b.payload->user_id;
+    });
+    next_event = 0;
+    events_populated = true;
+}
+
+inline void Simulator::run() {
+    if (!events_populated) populate_initial_events();
+    if (verbose) std::cout << "--- 3. Starting Simulation ---" << std::endl;
+    long long current_time = (simulation_threads > 1 && npus.size() > 1) ? run_sharded() : run_sequential();
+    binary_log.close();
+    if (verbose) {
+        std::cout << std::endl;
+        std::cout << "Simulation Finished at time: " << current_time - 1 << " ms." << std::endl;
+    }
+}
+
+inline void Simulator::finish_task(int user_id, int batch_size, long long current_time, long long& processed_samples) {
+    User& user = users[user_id - 1];
+    cumulative_batch_size_processed += batch_size;
+    if (!user.has_finished && user.cnt_processed + batch_size >= user.cnt_required) {
+        user.has_finished = true;
+        if (current_time <= user.e) {
+            cumulative_users_completed_on_time++;
+        } else {
+            cumulative_users_timeout++;
+        }
+    }
+    user.cnt_processed += batch_size;
+    processed_samples += batch_size;
+    if (user.cnt_processed >= user.cnt_required) user.finish_time = current_time;
+}
+
+inline void Simulator::write_log_entry(const LogEntry& entry) {
+    if (record_log) log_data.push_back(entry);
+    if (binary_log.is_open()) binary_log.append(entry);
+}
+
+inline void Simulator::report_progress(long long processed_samples, long long current_time, int& last_percent) const {
+    const int BAR_WIDTH = 50;
+    int percent = (total_samples_to_process > 0) ? static_cast<int>(100.0 * processed_samples / total_samples_to_process) : 100;
+    if (percent > last_percent) {
+        last_percent = percent;
+        std::cout << "[";
+        int pos = BAR_WIDTH * percent / 100;
+        for (int i = 0; i < BAR_WIDTH; ++i) {
+            if (i < pos) std::cout << "="; else if (i == pos) std::cout << ">"; else std::cout << " ";
+        }
+        std::cout << "] " << percent << "% | Time: " << current_time << "ms\r";
+        std::cout.flush();
+    }
+}
+
+// ؽʱ current_timeʱ + 1
+inline long long Simulator::run_sequential() {
+    long long current_time = 0;
+    long long processed_samples = 0;
+    std::set<int> npus_to_re_evaluate;
+    std::vector<int> completed_batch_per_npu_tick(npus.size(), 0);
+    int last_percent = -1;
+    // ֻɡͻ򵽴ʱ̣ʱûκ״̬仯ֱ
+    const long long NO_EVENT = std::numeric_limits<long long>::max();
+    while (processed_samples < total_samples_to_process) {
+        if (current_time > 2000000) fail_with_error("Simulation Timeout", "Simulation exceeded maximum time limit (2,000,000ms).");
+        npus_to_re_evaluate.clear();
+        while (!completions.empty() && completions.top().first == current_time) {
+            npus_to_re_evaluate.insert(completions.top().second);
+            completions.pop();
+        }
+        for (int gid : npus_to_re_evaluate) {
+            auto& npu = npus[gid];
+            while (!npu.running_tasks.empty() && npu.running_tasks.front().finish_time == current_time) {
+                std::pop_heap(npu.running_tasks.begin(), npu.running_tasks.end(), std::greater<NPU::RunningTask>());
+                const NPU::RunningTask& task = npu.running_tasks.back();
+                completed_batch_per_npu_tick[gid] += task.request.batch_size;
+                finish_task(task.request.user_id, task.request.batch_size, current_time, processed_samples);
+                npu.used_memory -= task.memory_used;
+                npu.running_tasks.pop_back();
+            }
+        }
+        while (next_event < events.size() && events[next_event].time == current_time) {
+            const Event& event = events[next_event++];
+            const Request& payload = *event.payload;
+            if (event.type == EventType::SEND) {
+                User& user = users[payload.user_id - 1];
+                if (payload.send_time < user.next_allowed_send_time) fail_with_error("Invalid User Send Time (Runtime Check)", "User " + std::to_string(user.id) + " violation at t=" + std::to_string(payload.send_time));
+                user.next_allowed_send_time = payload.arrival_time + 1;
+                const auto& server = servers[payload.server_id - 1];
+                int npu_global_id = server.npu_global_ids[payload.npu_id - 1];
+                if (user.last_npu_global_id != -1 && user.last_npu_global_id != npu_global_id) user.migrations++;
+                user.last_npu_global_id = npu_global_id;
+            } else if (event.type == EventType::ARRIVE) {
+                const auto& server = servers[payload.server_id - 1];
+                int gid = server.npu_global_ids[payload.npu_id - 1];
+                const User& user = users[payload.user_id - 1];
+                int mem_needed = user.a * payload.batch_size + user.b;
+                npus[gid].queue.push(payload, mem_needed);
+                npus_to_re_evaluate.insert(gid);
+            }
+        }
+        for (int gid : npus_to_re_evaluate) {
+            auto& npu = npus[gid];
+            // ˳зŵµʣڴֻ֮ҲŲ£ÿδһλ֮
+            for (size_t pos = npu.queue.find_first(0, npu.memory_limit - npu.used_memory); pos != AdmissionQueue::npos;
+                 pos = npu.queue.find_first(pos + 1, npu.memory_limit - npu.used_memory)) {
+                const Request& request = npu.queue.request(pos);
+                int mem_needed = npu.queue.memory_needed(pos);
+                npu.used_memory += mem_needed;
+                const auto& server = servers[npu.server_id - 1];
+                long long time_needed = processing_time(server.k, request.batch_size);
+                npu.queue.take(pos);
+                // ʱ̲ڵǰʱ̣ʱ̵Ѿ񲻻
+                if (time_needed <= 0) { npu.stalled_tasks++; continue; }
+                npu.running_tasks.push_back({request, current_time + time_needed, mem_needed});
+                std::push_heap(npu.running_tasks.begin(), npu.running_tasks.end(), std::greater<NPU::RunningTask>());
+                completions.push({current_time + time_needed, gid});
+            }
+        }
+
+        // ʱɵNPU npus_to_re_evaluate Уֻ¼ЩNPU
+        if (record_log || binary_log.is_open()) {
+            for (int gid : npus_to_re_evaluate) {
+                const auto& npu = npus[gid];
+                write_log_entry({
+                    current_time,
+                    gid, npu.server_id, npu.local_id,
+                    npu.used_memory, npu.memory_limit,
+                    static_cast<int>(npu.queue.size()),
+                    npu.running_count(),
+                    completed_batch_per_npu_tick[gid],
+                    cumulative_batch_size_processed,
+                    cumulative_users_completed_on_time,
+                    cumulative_users_timeout
+                });
+            }
+        }
+        for (int gid : npus_to_re_evaluate) completed_batch_per_npu_tick[gid] = 0;
+
+        if (verbose) report_progress(processed_samples, current_time, last_percent);
+        if (processed_samples >= total_samples_to_process) {
+            current_time++;
+            break;
+        }
+        long long next_finish_time = completions.empty() ? NO_EVENT : completions.top().first;
+        long long next_time = std::min(next_finish_time, next_event < events.size() ? events[next_event].time : NO_EVENT);
+        // ûк¼ȴδʱԭ߼ȼһֱתʱ
+        current_time = (next_time == NO_EVENT) ? 2000001 : std::max(next_time, current_time + 1);
+    }
+    return current_time;
+}
+
+// ģһNPU run_sequential ͬarrivals (ʱ, ûid)
+// ֻ users  serversֻд npus[gid]  traceԲͬNPUڲͬ߳ͬʱģ
+inline void Simulator::simulate_npu(int gid, const std::vector<const Request*>& arrivals, NpuTrace& trace) {
+    auto& npu = npus[gid];
+    const auto& server = servers[npu.server_id - 1];
+    const long long NO_EVENT = std::numeric_limits<long long>::max();
+    size_t next = 0;
+    while (true) {
+        long long current_time = npu.running_tasks.empty() ? NO_EVENT : npu.running_tasks.front().finish_time;
+        if (next < arrivals.size()) current_time = std::min(current_time, arrivals[next]->arrival_time);
+        // ʱ޵ʱ̲ᱻϲʱ run_sharded 
+        if (current_time == NO_EVENT || current_time > 2000000) break;
+        int completed_batch = 0;
+        while (!npu.running_tasks.empty() && npu.running_tasks.front().finish_time == current_time) {
+            std::pop_heap(npu.running_tasks.begin(), npu.running_tasks.end(), std::greater<NPU::RunningTask>());
+            const NPU::RunningTask& task = npu.running_tasks.back();
+            completed_batch += task.request.batch_size;
+            trace.completed.push_back({task.request.user_id, task.request.batch_size});
+            npu.used_memory -= task.memory_used;
+            npu.running_tasks.pop_back();
+        }
+        for (; next < arrivals.size() && arrivals[next]->arrival_time == current_time; ++next) {
+            const Request& payload = *arrivals[next];
+            const User& user = users[payload.user_id - 1];
+            npu.queue.push(payload, user.a * payload.batch_size + user.b);
+        }
+        for (size_t pos = npu.queue.find_first(0, npu.memory_limit - npu.used_memory); pos != AdmissionQueue::npos;
+             pos = npu.queue.find_first(pos + 1, npu.memory_limit - npu.used_memory)) {
+            const Request& request = npu.queue.request(pos);
+            int mem_needed = npu.queue.memory_needed(pos);
+            npu.used_memory += mem_needed;
+            long long time_needed = processing_time(server.k, request.batch_size);
+            npu.queue.take(pos);
+            if (time_needed <= 0) { npu.stalled_tasks++; continue; }
+            npu.running_tasks.push_back({request, current_time + time_needed, mem_needed});
+            std::push_heap(npu.running_tasks.begin(), npu.running_tasks.end(), std::greater<NPU::RunningTask>());
+        }
+        trace.ticks.push_back({current_time, npu.used_memory, static_cast<int>(npu.queue.size()),
+                               npu.running_count(), completed_batch, trace.completed.size()});
+    }
+}
+
+// NPUƬģ⡣NPUֻ֮ͨۼʱ/ʱû໥Ӱ죬Щֻ־У
+// ߳ȶģԵNPUٰ(ʱ, NPUȫid)鲢NPUʱУνɵд־
+//  run_sequential λͬ͵ĺϷڽʱ̬飬Ǩƴֻȡڷ˳ģ˳
+inline long long Simulator::run_sharded() {
+    // ÿûĵʱϸûid˳ȶΪ(ʱ, ûid)˳
+    std::vector<std::vector<const Request*>> arrivals(npus.size());
+    for (const User& user : users) {
+        for (const auto& req : user.requests) arrivals[servers[req.server_id - 1].npu_global_ids[req.npu_id - 1]].push_back(&req);
+    }
+    std::vector<NpuTrace> traces(npus.size());
+    std::atomic<size_t> next_npu{0};
+    auto worker = [&]() {
+        for (size_t gid; (gid = next_npu++) < npus.size();) {
+            std::stable_sort(arrivals[gid].begin(), arrivals[gid].end(),
+                             [](const Request* a, const Request* b) { return a->arrival_time < b->arrival_time; });
+            simulate_npu(gid, arrivals[gid], traces[gid]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 0; i < std::min<int>(simulation_threads, npus.size()); ++i) pool.emplace_back(worker);
+    for (auto& thread : pool) thread.join();
+
+    long long current_time = 0;
+    long long processed_samples = 0;
+    int last_percent = -1;
+    std::vector<size_t> cursor(npus.size(), 0);
+    // ÿNPUһе(ʱ, NPUȫid)
+    std::priority_queue<std::pair<long long, int>, std::vector<std::pair<long long, int>>, std::greater<std::pair<long long, int>>> heads;
+    for (size_t gid = 0; gid < npus.size(); ++gid) {
+        if (!traces[gid].ticks.empty()) heads.push({traces[gid].ticks[0].time, static_cast<int>(gid)});
+    }
+    std::vector<int> npus_to_re_evaluate;
+    const long long NO_EVENT = std::numeric_limits<long long>::max();
+    while (processed_samples < total_samples_to_process) {
+        if (current_time > 2000000) fail_with_error("Simulation Timeout", "Simulation exceeded maximum time limit (2,000,000ms).");
+        npus_to_re_evaluate.clear();
+        while (!heads.empty() && heads.top().first == current_time) {
+            npus_to_re_evaluate.push_back(heads.top().second);
+            heads.pop();
+        }
+        // Ƚ㱾ʱNPUɵٰNPUȫid˳д־뵥̵߳Ĵ˳ͬ
+        for (int gid : npus_to_re_evaluate) {
+            const NpuTrace& trace = traces[gid];
+            size_t begin = cursor[gid] == 0 ? 0 : trace.ticks[cursor[gid] - 1].completed_end;
+            for (size_t i = begin; i < trace.ticks[cursor[gid]].completed_end; ++i) {
+                finish_task(trace.completed[i].first, trace.completed[i].second, current_time, processed_samples);
+            }
+        }
+        for (int gid : npus_to_re_evaluate) {
+            const NpuTrace& trace = traces[gid];
+            const auto& tick = trace.ticks[cursor[gid]++];
+            if (record_log || binary_log.is_open()) {
+                const auto& npu = npus[gid];
+                write_log_entry({
+                    current_time,
+                    gid, npu.server_id, npu.local_id,
+                    tick.used_memory, npu.memory_limit,
+                    tick.queue_size,
+                    tick.running_count,
+                    tick.completed_batch,
+                    cumulative_batch_size_processed,
+                    cumulative_users_completed_on_time,
+                    cumulative_users_timeout
+                });
+            }
+            if (cursor[gid] < trace.ticks.size()) heads.push({trace.ticks[cursor[gid]].time, gid});
+        }
+
+        if (verbose) report_progress(processed_samples, current_time, last_percent);
+        if (processed_samples >= total_samples_to_process) {
+            current_time++;
+            break;
+        }
+        long long next_time = heads.empty() ? NO_EVENT : heads.top().first;
+        current_time = (next_time == NO_EVENT) ? 2000001 : std::max(next_time, current_time + 1);
+    }
+    // ߳ģһɵʱ֮̽ķֻͣbatchΪ󣩲ᱻҲǨ
+    for (User& user : users) {
+        for (const auto& req : user.requests) {
+            if (req.send_time >= current_time) break;
+            int npu_global_id = servers[req.server_id - 1].npu_global_ids[req.npu_id - 1];
+            if (user.last_npu_global_id != -1 && user.last_npu_global_id != npu_global_id) user.migrations++;
+            user.last_npu_global_id = npu_global_id;
+            user.next_allowed_send_time = req.arrival_time + 1;
+        }
+    }
+    return current_time;
+}
+
+template <class Scoring>
+ScoreSummary Simulator::compute_score() const {
+    ScoreSummary summary;
+    double total_score = 0; int late_users_count = 0;
+    for (const User& user : users) {
+        if (user.finish_time > user.e) late_users_count++;
+        if constexpr (Scoring::require_finished) {
+            if (user.finish_time == -1) fail_with_error("Scoring Error", "User " + std::to_string(user.id) + " did not finish.");
+        }
+    }
+    for (const User& user : users) {
+        long long finish_time = user.finish_time;
+        if constexpr (!Scoring::require_finished) finish_time = (finish_time == -1) ? Scoring::unfinished_finish_time : finish_time;
+        total_score += user_score<Scoring>(user, finish_time, user.migrations);
+    }
+    double k_penalty = Scoring::late_penalty(late_users_count);
+    summary.total_users = users.size();
+    summary.late_users = late_users_count;
+    summary.k_penalty = k_penalty;
+    summary.total_score = total_score;
+    summary.final_score = k_penalty * total_score;
+    return summary;
+}
+
+template <class Scoring>
+void Simulator::calculate_score() {
+    std::cout << "--- 4. Calculating Score ---" << std::endl;
+    ScoreSummary summary = compute_score<Scoring>();
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "\n--- Scoring Summary ---" << std::endl;
+    std::cout << "Total Users: " << summary.total_users << std::endl;
+    std::cout << "Late Users (K): " << summary.late_users << std::endl;
+    std::cout << "K Penalty h(K): " << summary.k_penalty << std::endl;
+    std::cout << "Sum of User Scores (before K penalty): " << summary.total_score << std::endl;
+    std::cout << "-------------------------" << std::endl;
+    std::cout << "FINAL SCORE: " << summary.final_score << std::endl;
+    std::cout << "-------------------------" << std::endl;
+}
+
+
+inline void Simulator::save_log_file(const std::string& filepath) {
+    std::cout << "--- 5. Saving Comprehensive Log ---" << std::endl;
+    if (log_data.empty()) {
+        std::cout << "No log data was recorded." << std::endl;
+        return;
+    }
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error saving log to '" << filepath << "'" << std::endl;
+        return;
+    }
+
+    write_log_header(file);
+    for (const auto& entry : log_data) write_log_row(file, entry);
+    std::cout << "Comprehensive log successfully saved to '" << filepath << "'" << std::endl;
+}
+
+// ѶNPU־ת save_log_file ıʽ
+inline void convert_binary_log(const std::string& binary_path, const std::string& text_path) {
+    BinaryLogReader reader(binary_path);
+    std::ofstream file(text_path);
+    if (!file.is_open()) throw ValidationError("Log File Error", "Could not open file: " + text_path);
+    write_log_header(file);
+    LogEntry entry;
+    while (reader.next(entry)) write_log_row(file, entry);
+}
+
+
+// ޸4ûͳ־ı溯
+inline void Simulator::save_users_log(const std::string& filepath) {
+    std::cout << "--- 6. Saving Users Log ---" << std::endl;
+
+    std::vector<UserLogEntry> user_logs;
+    for (const User& user : users) {
+        if (user.finish_time == -1) { // ûδɣһ
+            fail_with_error("User Log Error", "User " + std::to_string(user.id) + " did not finish all samples.");
+        }
+        double avg_bs = 0;
+        if (!user.requests.empty()) {
+            avg_bs = static_cast<double>(user.cnt_required) / user.requests.size();
+        }
+        user_logs.push_back({
+            user.id,
+            user.s,
+            user.e,
+            user.cnt_required,
+            static_cast<int>(user.requests.size()),
+            user.finish_time,
+            user.finish_time - user.e,
+            avg_bs
+        });
+    }
+
+    //  cnt 
+    std::sort(user_logs.begin(), user_logs.end(), [](const UserLogEntry& a, const UserLogEntry& b){
+        return a.cnt < b.cnt;
+    });
+
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "Error saving users log to '" << filepath << "'" << std::endl;
+        return;
+    }
+
+    file << std::left
+         << std::setw(10) << "User_ID"
+         << std::setw(10) << "s_time"
+         << std::setw(10) << "e_time"
+         << std::setw(10) << "cnt"
+         << std::setw(18) << "Request_Count"
+         << std::setw(15) << "Finish_Time"
+         << std::setw(15) << "Time_Diff"
+         << "Avg_Batch_Size" << "\n";
+    file << std::string(100, '-') << "\n";
+
+    for (const auto& entry : user_logs) {
+        file << std::left << std::fixed << std::setprecision(2)
+             << std::setw(10) << entry.user_id
+             << std::setw(10) << entry.s
+             << std::setw(10) << entry.e
+             << std::setw(10) << entry.cnt
+             << std::setw(18) << entry.request_count
+             << std::setw(15) << entry.finish_time
+             << std::setw(15) << entry.time_diff
+             << entry.avg_batch_size << "\n";
+    }
+    std::cout << "Users log successfully saved to '" << filepath << "'" << std::endl;
+}
+
+// ---  ---
+// ͼƻеһηͣļеһͬ
+struct ScheduledSend {
+    long long send_time;
+    int server_id, npu_id, batch_size;
+};
+// һûµͼƻ
+struct UserSchedule {
+    int user_id;
+    std::vector<ScheduledSend> sends;
+};
+
+// һģΪ׼ֻ޸ûķͼƻ֣ھֲ̽޸ġ
+// NPUֻ֮ͨûʱ䣨ʱֵ໥Ӱ죬ֻģ¾вNPU
+// ҴӲ쵽ʱļ㿪ʼ㱣ĳһʱ̴֮ǰNPUڴ桢͵ȴС
+// base ѼҪ runڱʹڼ䱣Ч
+template <class Scoring = StandardScoring>
+class IncrementalScorer {
+public:
+    explicit IncrementalScorer(const Simulator& base, int checkpoint_interval = 64);
+
+    const ScoreSummary& score() const { return summary; }
+    // ޸ĺĵ÷֣ı׼ͼƻϷģⳬʱʱ׳ ValidationError
+    ScoreSummary evaluate(const std::vector<UserSchedule>& diff) { return rescore(diff, false); }
+    // ޸ĺĵ÷֣޸ĺķΪµĻ׼
+    ScoreSummary apply(const std::vector<UserSchedule>& diff) { return rescore(diff, true); }
+
+private:
+    static constexpr long long NEVER = -1; // ʱ䲻ΪbatchΪԶɣ Simulator::run һ
+
+    // ͬһNPUϵ󣬰(ʱ, ûid)򣬼׼˳
+    struct Task {
+        long long arrival;
+        int user_id, batch_size, memory;
+        long long duration;
+        bool operator<(const Task& other) const {
+            if (arrival != other.arrival) return arrival < other.arrival;
+            return user_id < other.user_id;
+        }
+        bool operator==(const Task& other) const {
+            return arrival == other.arrival && user_id == other.user_id && batch_size == other.batch_size;
+        }
+    };
+    // time ʱ̴֮ǰNPU״̬ǰ޸ǰȫͬԿֱӴģ
+    struct Checkpoint {
+        long long time = 0;
+        size_t next_arrival = 0;
+        int used_memory = 0;
+        std::vector<std::pair<long long, int>> running; // (ʱ, ڴ)С
+        std::vector<int> pending; // ѵδʼ±꣬׼˳
+    };
+    struct Timeline {
+        std::vector<Task> tasks;
+        std::vector<long long> completion; //  tasks һһӦ
+        std::vector<Checkpoint> checkpoints;
+        std::vector<std::pair<int, long long>> user_finish; // (ûid, ûڴNPUʱ)ûid
+        long long max_completion = NEVER;
+    };
+    // ȴУ±άڴСֵѿʼδλΪINF
+    class PendingTree {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        explicit PendingTree(size_t n) {
+            while (capacity < n) capacity *= 2;
+            tree.assign(2 * capacity, INF);
+        }
+        void set(size_t pos, int value) {
+            size_t i = capacity + pos;
+            tree[i] = value;
+            for (i /= 2; i >= 1; i /= 2) tree[i] = std::min(tree[2 * i], tree[2 * i + 1]);
+        }
+        void clear(size_t pos) { set(pos, INF); }
+        size_t find_first(size_t from, int limit) const { return tree[1] > limit ? npos : find_first(1, 0, capacity, from, limit); }
+        void collect(std::vector<int>& out) const { collect(1, 0, capacity, out); }
+    private:
+        static constexpr int INF = std::numeric_limits<int>::max();
+        size_t capacity = 1;
+        std::vector<int> tree;
+        size_t find_first(size_t node, size_t lo, size_t hi, size_t from, int limit) const {
+            if (hi <= from || tree[node] > limit) return npos;
+            if (hi - lo == 1) return lo;
+            size_t mid = (lo + hi) / 2;
+            size_t pos = find_first(2 * node, lo, mid, from, limit);
+            return pos != npos ? pos : find_first(2 * node + 1, mid, hi, from, limit);
+        }
+        void collect(size_t node, size_t lo, size_t hi, std::vector<int>& out) const {
+            if (tree[node] == INF) return;
+            if (hi - lo == 1) { out.push_back(lo); return; }
+            size_t mid = (lo + hi) / 2;
+            collect(2 * node, lo, mid, out);
+            collect(2 * node + 1, mid, hi, out);
+        }
+    };
+
+    const Simulator& sim;
+    size_t interval;
+    std::vector<std::vector<Request>> requests; // ǰÿû±Ϊ user_id - 1
+    std::vector<Timeline> timelines;            // ±ΪNPUȫid
+    std::vector<long long> finish;
+    std::vector<int> migrations;
+    std::vector<double> user_scores;
+    int nonpositive_requests = 0; // ǰbatchΪ
+    ScoreSummary summary;
+
+    static int count_nonpositive(const std::vector<Request>& user_requests) {
+        return std::count_if(user_requests.begin(), user_requests.end(), [](const Request& r) { return r.batch_size <= 0; });
+    }
+
+    int npu_of(const Request& request) const { return sim.servers[request.server_id - 1].npu_global_ids[request.npu_id - 1]; }
+    Task make_task(const Request& request) const {
+        const User& user = sim.users[request.user_id - 1];
+        int k = sim.servers[request.server_id - 1].k;
+        return {request.arrival_time, request.user_id, request.batch_size, user.a * request.batch_size + user.b,
+                Simulator::processing_time(k, request.batch_size)};
+    }
+    // end_time Ϊģʱ current_time֮ķͲᱻ
+    int count_migrations(const std::vector<Request>& user_requests, long long end_time = std::numeric_limits<long long>::max()) const {
+        int count = 0, last = -1;
+        for (const auto& request : user_requests) {
+            if (request.send_time >= end_time) break;
+            int gid = npu_of(request);
+            if (last != -1 && last != gid) count++;
+            last = gid;
+        }
+        return count;
+    }
+    static double score_of(const User& user, long long finish_time, int user_migrations) {
+        if constexpr (!Scoring::require_finished) finish_time = (finish_time == NEVER) ? Scoring::unfinished_finish_time : finish_time;
+        return Simulator::user_score<Scoring>(user, finish_time, user_migrations);
+    }
+    void replay(Timeline& timeline, int memory_limit, const Checkpoint& start, bool record) const;
+    static void summarize(Timeline& timeline);
+    static long long user_finish_on(const Timeline& timeline, int user_id) {
+        auto it = std::lower_bound(timeline.user_finish.begin(), timeline.user_finish.end(), std::make_pair(user_id, NEVER));
+        return (it != timeline.user_finish.end() && it->first == user_id) ? it->second : NEVER;
+    }
+    ScoreSummary rescore(const std::vector<UserSchedule>& diff, bool commit);
+};
+
+template <class Scoring>
+IncrementalScorer<Scoring>::IncrementalScorer(const Simulator& base, int checkpoint_interval)
+    : sim(base), interval(std::max(1, checkpoint_interval)), timelines(base.npus.size()) {
+    for (const User& user : sim.users) {
+        requests.push_back(user.requests);
+        nonpositive_requests += count_nonpositive(user.requests);
+        for (const auto& request : user.requests) timelines[npu_of(request)].tasks.push_back(make_task(request));
+    }
+    for (size_t gid = 0; gid < timelines.size(); ++gid) {
+        Timeline& timeline = timelines[gid];
+        std::sort(timeline.tasks.begin(), timeline.tasks.end());
+        timeline.completion.assign(timeline.tasks.size(), NEVER);
+        replay(timeline, sim.npus[gid].memory_limit, Checkpoint{}, true);
+        summarize(timeline);
+    }
+    // ׼޸һΣõÿûʱ͵÷
+    finish.assign(sim.users.size(), NEVER);
+    migrations.assign(sim.users.size(), 0);
+    user_scores.assign(sim.users.size(), 0);
+    for (const User& user : sim.users) {
+        for (const auto& request : requests[user.id - 1]) finish[user.id - 1] = std::max(finish[user.id - 1], user_finish_on(timelines[npu_of(request)], user.id));
+        migrations[user.id - 1] = count_migrations(requests[user.id - 1]);
+        user_scores[user.id - 1] = score_of(user, finish[user.id - 1], migrations[user.id - 1]);
+    }
+    summary = rescore({}, true);
+}
+
+//  start ʼĹģⵥNPUÿɻ󵽴ʱ̣ͷڴ棬
+// ټ뵽Ȼ׼˳ʼзŵµrecord ʱÿ interval ʱ̱һ
+template <class Scoring>
+void IncrementalScorer<Scoring>::replay(Timeline& timeline, int memory_limit, const Checkpoint& start, bool record) const {
+    const std::vector<Task>& tasks = timeline.tasks;
+    PendingTree pending(tasks.size());
+    for (int i : start.pending) pending.set(i, tasks[i].memory);
+    std::vector<std::pair<long long, int>> running = start.running;
+    size_t next = start.next_arrival;
+    int used = start.used_memory;
+    auto later = std::greater<std::pair<long long, int>>();
+    // ͷģʱһʱ̾ͱ㣬ӼʱüѾ
+    size_t since_checkpoint = timeline.checkpoints.empty() ? interval - 1 : 0;
+    const long long NO_EVENT = std::numeric_limits<long long>::max();
+    while (true) {
+        long long t = running.empty() ? NO_EVENT : running.front().first;
+        if (next < tasks.size()) t = std::min(t, tasks[next].arrival);
+        if (t == NO_EVENT) break;
+        if (record && ++since_checkpoint >= interval) {
+            since_checkpoint = 0;
+            Checkpoint checkpoint{t, next, used, running, {}};
+            pending.collect(checkpoint.pending);
+            timeline.checkpoints.push_back(std::move(checkpoint));
+        }
+        while (!running.empty() && running.front().first == t) {
+            std::pop_heap(running.begin(), running.end(), later);
+            used -= running.back().second;
+            running.pop_back();
+        }
+        for (; next < tasks.size() && tasks[next].arrival == t; ++next) pending.set(next, tasks[next].memory);
+        for (size_t pos = pending.find_first(0, memory_limit - used); pos != PendingTree::npos;
+             pos = pending.find_first(pos + 1, memory_limit - used)) {
+            used += tasks[pos].memory;
+            pending.clear(pos);
+            if (tasks[pos].duration <= 0) continue; // ɣһֱռڴ
+            timeline.completion[pos] = t + tasks[pos].duration;
+            running.push_back({timeline.completion[pos], tasks[pos].memory});
+            std::push_heap(running.begin(), running.end(), later);
+        }
+    }
+}
+
+template <class Scoring>
+void IncrementalScorer<Scoring>::summarize(Timeline& timeline) {
+    timeline.user_finish.clear();
+    timeline.max_completion = NEVER;
+    for (size_t i = 0; i < timeline.tasks.size(); ++i) {
+        timeline.user_finish.push_back({timeline.tasks[i].user_id, timeline.completion[i]});
+        timeline.max_completion = std::max(timeline.max_completion, timeline.completion[i]);
+    }
+    std::sort(timeline.user_finish.begin(), timeline.user_finish.end());
+    // ÿûֻʱ
+    auto last = timeline.user_finish.begin();
+    for (auto it = timeline.user_finish.begin(); it != timeline.user_finish.end(); ++it) {
+        if (last != it && last->first == it->first) *last = *it;
+        else if (last != it) *++last = *it;
+    }
+    if (!timeline.user_finish.empty()) timeline.user_finish.erase(last + 1, timeline.user_finish.end());
+}
+
+template <class Scoring>
+ScoreSummary IncrementalScorer<Scoring>::rescore(const std::vector<UserSchedule>& diff, bool commit) {
+    // 1. ûid˳̬µķͼƻļʱͬԱĴҲͬ
+    std::map<int, const UserSchedule*> schedules;
+    for (const auto& schedule : diff) {
+        if (schedule.user_id < 1 || (size_t)schedule.user_id > sim.users.size()) throw std::out_of_range("IncrementalScorer: user_id " + std::to_string(schedule.user_id));
+        schedules[schedule.user_id] = &schedule;
+    }
+    std::map<int, std::vector<Request>> changed;
+    for (const auto& [user_id, schedule] : schedules) {
+        const User& user = sim.users[user_id - 1];
+        Simulator::check_request_count(user.id, schedule->sends.size());
+        std::vector<Request> user_requests;
+        for (const auto& send : schedule->sends) {
+            user_requests.push_back(sim.make_request(user, user_requests, send.send_time, send.server_id, send.npu_id, send.batch_size));
+        }
+        Simulator::check_total_samples(user, user_requests);
+        changed[user.id] = std::move(user_requests);
+    }
+
+    // 2. ÿNPU¾һγֲĵʱ
+    std::map<int, long long> affected_from;
+    for (const auto& [user_id, new_requests] : changed) {
+        std::map<int, std::pair<std::vector<Task>, std::vector<Task>>> per_npu; // NPU -> (, )
+        for (const auto& request : requests[user_id - 1]) per_npu[npu_of(request)].first.push_back(make_task(request));
+        for (const auto& request : new_requests) per_npu[npu_of(request)].second.push_back(make_task(request));
+        for (const auto& [gid, old_and_new] : per_npu) {
+            const auto& [old_tasks, new_tasks] = old_and_new;
+            size_t i = 0;
+            while (i < old_tasks.size() && i < new_tasks.size() && old_tasks[i] == new_tasks[i]) ++i;
+            if (i == old_tasks.size() && i == new_tasks.size()) continue;
+            long long t = std::min(i < old_tasks.size() ? old_tasks[i].arrival : std::numeric_limits<long long>::max(),
+                                   i < new_tasks.size() ? new_tasks[i].arrival : std::numeric_limits<long long>::max());
+            auto it = affected_from.find(gid);
+            if (it == affected_from.end() || t < it->second) affected_from[gid] = t;
+        }
+    }
+
+    // 3. ֻģЩNPU޸ĺ󣬴һڲʱļ
+    std::map<int, Timeline> replayed;
+    std::set<int> touched_users;
+    for (const auto& [gid, from] : affected_from) {
+        const Timeline& old = timelines[gid];
+        Timeline timeline;
+        for (const Task& task : old.tasks) {
+            if (!changed.count(task.user_id)) timeline.tasks.push_back(task);
+            touched_users.insert(task.user_id);
+        }
+        for (const auto& [user_id, new_requests] : changed) {
+            for (const auto& request : new_requests) {
+                if (npu_of(request) == gid) timeline.tasks.push_back(make_task(request));
+            }
+        }
+        std::sort(timeline.tasks.begin(), timeline.tasks.end());
+        for (const Task& task : timeline.tasks) touched_users.insert(task.user_id);
+
+        auto cp = std::upper_bound(old.checkpoints.begin(), old.checkpoints.end(), from,
+                                   [](long long t, const Checkpoint& c) { return t < c.time; });
+        Checkpoint start = (cp == old.checkpoints.begin()) ? Checkpoint{} : *(cp - 1);
+        // ֮ǰ޸ǰͬѾʼʱ䲻
+        timeline.completion.assign(timeline.tasks.size(), NEVER);
+        std::copy(old.completion.begin(), old.completion.begin() + start.next_arrival, timeline.completion.begin());
+        for (int i : start.pending) timeline.completion[i] = NEVER;
+        if (commit) timeline.checkpoints.assign(old.checkpoints.begin(), cp);
+        replay(timeline, sim.npus[gid].memory_limit, start, commit);
+        summarize(timeline);
+        replayed[gid] = std::move(timeline);
+    }
+    for (const auto& [user_id, _] : changed) touched_users.insert(user_id);
+
+    auto timeline_of = [&](int gid) -> const Timeline& {
+        auto it = replayed.find(gid);
+        return it != replayed.end() ? it->second : timelines[gid];
+    };
+    int new_nonpositive = nonpositive_requests;
+    for (const auto& [user_id, new_requests] : changed) new_nonpositive += count_nonpositive(new_requests) - count_nonpositive(requests[user_id - 1]);
+
+    // 4. ¼Ӱûʱ͵÷֣ܷ԰û˳ۼӣ compute_score Ľȫһ
+    struct UserResult { long long finish; int migrations; double score; };
+    std::map<int, UserResult> updated;
+    if (new_nonpositive > 0 || nonpositive_requests > 0) {
+        // batchΪʱģۼһδﵽʱ̽һɣ
+        // ûʱ䡢Ǩƴ֮ķͲٴȡNPUɵȺ԰ʱû
+        // ׼ʱ֮ǰûҲɵĽʱ̣ͬҪ
+        std::vector<std::tuple<long long, int, int>> done; // (ʱ, ûid, batch)
+        for (size_t gid = 0; gid < timelines.size(); ++gid) {
+            const Timeline& timeline = timeline_of(gid);
+            for (size_t i = 0; i < timeline.tasks.size(); ++i) {
+                if (timeline.completion[i] != NEVER) done.emplace_back(timeline.completion[i], timeline.tasks[i].user_id, timeline.tasks[i].batch_size);
+            }
+        }
+        std::sort(done.begin(), done.end());
+        std::vector<long long> processed(sim.users.size(), 0), last_completion(sim.users.size(), NEVER);
+        long long total_processed = 0, end_time = 0;
+        if (sim.total_samples_to_process > 0) {
+            long long end_tick = NEVER;
+            for (size_t i = 0; i < done.size() && end_tick == NEVER;) {
+                long long t = std::get<0>(done[i]);
+                if (t > 2000000) break;
+                for (; i < done.size() && std::get<0>(done[i]) == t; ++i) {
+                    auto [time, user_id, batch_size] = done[i];
+                    total_processed += batch_size;
+                    processed[user_id - 1] += batch_size;
+                    last_completion[user_id - 1] = time;
+                }
+                if (total_processed >= sim.total_samples_to_process) end_tick = t;
+            }
+            if (end_tick == NEVER) Simulator::fail_with_error("Simulation Timeout", "Simulation exceeded maximum time limit (2,000,000ms).");
+            end_time = end_tick + 1;
+        }
+        for (const User& user : sim.users) {
+            auto it = changed.find(user.id);
+            const std::vector<Request>& user_requests = (it != changed.end()) ? it->second : requests[user.id - 1];
+            long long user_finish = (processed[user.id - 1] >= user.cnt_required) ? last_completion[user.id - 1] : NEVER;
+            int user_migrations = count_migrations(user_requests, end_time);
+            updated[user.id] = {user_finish, user_migrations, score_of(user, user_finish, user_migrations)};
+        }
+        touched_users.clear();
+    } else {
+        // 󶼻ɣһɵʱ̼ģʱ
+        long long max_completion = NEVER;
+        for (size_t gid = 0; gid < timelines.size(); ++gid) max_completion = std::max(max_completion, timeline_of(gid).max_completion);
+        if (max_completion > 2000000) Simulator::fail_with_error("Simulation Timeout", "Simulation exceeded maximum time limit (2,000,000ms).");
+    }
+    for (int user_id : touched_users) {
+        auto it = changed.find(user_id);
+        const std::vector<Request>& user_requests = (it != changed.end()) ? it->second : requests[user_id - 1];
+        long long user_finish = NEVER;
+        for (const auto& request : user_requests) user_finish = std::max(user_finish, user_finish_on(timeline_of(npu_of(request)), user_id));
+        int user_migrations = (it != changed.end()) ? count_migrations(user_requests) : migrations[user_id - 1];
+        updated[user_id] = {user_finish, user_migrations, score_of(sim.users[user_id - 1], user_finish, user_migrations)};
+    }
+    ScoreSummary result;
+    double total_score = 0; int late_users_count = 0;
+    for (const User& user : sim.users) {
+        auto it = updated.find(user.id);
+        long long user_finish = (it != updated.end()) ? it->second.finish : finish[user.id - 1];
+        if (user_finish > user.e) late_users_count++;
+        if constexpr (Scoring::require_finished) {
+            if (user_finish == NEVER) Simulator::fail_with_error("Scoring Error", "User " + std::to_string(user.id) + " did not finish.");
+        }
+    }
+    for (const User& user : sim.users) {
+        auto it = updated.find(user.id);
+        total_score += (it != updated.end()) ? it->second.score : user_scores[user.id - 1];
+    }
+    result.total_users = sim.users.size();
+    result.late_users = late_users_count;
+    result.k_penalty = Scoring::late_penalty(late_users_count);
+    result.total_score = total_score;
+    result.final_score = result.k_penalty * total_score;
+
+    if (commit) {
+        for (auto& [gid, timeline] : replayed) timelines[gid] = std::move(timeline);
+        for (auto& [user_id, user_requests] : changed) requests[user_id - 1] = std::move(user_requests);
+        nonpositive_requests = new_nonpositive;
+        for (const auto& [user_id, value] : updated) {
+            finish[user_id - 1] = value.finish;
+            migrations[user_id - 1] = value.migrations;
+            user_scores[user_id - 1] = value.score;
+        }
+        summary = result;
+    }
+    return result;
+}
+
+} // namespace validator